@@ -0,0 +1,35 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#ifndef AUTHSTORE_H
+#define AUTHSTORE_H
+
+#include <string>
+#include <vector>
+#include <utility>
+
+// 用户存储接口：登录注册只通过它读写用户，启动时选择 MySQL 或本地文件实现。
+// 实现需要可被多个数据库线程同时调用
+class AuthStore {
+public:
+    virtual ~AuthStore() {}
+
+    // 查询用户，存储出错时返回 false；found 表示用户是否存在，存在时 password 为保存的密码记录
+    virtual bool Find(const std::string& name, std::string* password, bool* found) = 0;
+
+    // 新增用户，出错或用户已存在时返回 false
+    virtual bool Insert(const std::string& name, const std::string& password) = 0;
+
+    // 批量新增用户，ok[i] 为第 i 个用户是否新增成功，同一批中重复的用户名只有第一个可能成功。
+    // 默认逐个调用 Insert，需要减少往返次数的实现可以重写
+    virtual void InsertBatch(const std::vector<std::pair<std::string, std::string>>& users, std::vector<bool>* ok) {
+        ok->assign(users.size(), false);
+        for(size_t i = 0; i < users.size(); i++) { (*ok)[i] = Insert(users[i].first, users[i].second); }
+    }
+
+    virtual const char* Name() const = 0;
+};
+
+#endif //AUTHSTORE_H
@@ -0,0 +1,105 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#include "localauthstore.h"
+
+using namespace std;
+
+LocalAuthStore::LocalAuthStore() : fd_(-1) {}
+
+LocalAuthStore::~LocalAuthStore() {
+    if(fd_ >= 0) { close(fd_); }
+}
+
+// 打开（不存在时创建）用户文件并载入全部用户
+bool LocalAuthStore::Open(const string& path, string* err) {
+    assert(fd_ < 0);
+    int fd = open(path.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0600);
+    if(fd < 0) {
+        *err = "cannot open " + path + ": " + strerror(errno);
+        return false;
+    }
+    struct stat st;
+    if(fstat(fd, &st) < 0) {
+        *err = "cannot stat " + path + ": " + strerror(errno);
+        close(fd);
+        return false;
+    }
+    size_t size = st.st_size;
+    if(size > 0) {
+        void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(data == MAP_FAILED) {
+            *err = "cannot mmap " + path + ": " + strerror(errno);
+            close(fd);
+            return false;
+        }
+        size_t valid = Load_(static_cast<const char*>(data), size);
+        munmap(data, size);
+        if(valid < size) {
+            LOG_WARN("%s: dropped %zu trailing bytes of a partial record", path.c_str(), size - valid);
+            if(ftruncate(fd, valid) < 0) {
+                *err = "cannot truncate " + path + ": " + strerror(errno);
+                close(fd);
+                return false;
+            }
+        }
+    }
+    fd_ = fd;
+    LOG_INFO("Local auth store %s: %zu users", path.c_str(), users_.size());
+    return true;
+}
+
+// 重放记录，返回完整记录占用的字节数；同名用户以先写入的为准
+size_t LocalAuthStore::Load_(const char* data, size_t size) {
+    size_t pos = 0;
+    while(size - pos >= HEAD_SIZE) {
+        uint16_t nameLen, pwdLen;
+        memcpy(&nameLen, data + pos, 2);
+        memcpy(&pwdLen, data + pos + 2, 2);
+        if(size - pos - HEAD_SIZE < static_cast<size_t>(nameLen) + pwdLen) { break; }
+        const char* p = data + pos + HEAD_SIZE;
+        users_.emplace(string(p, nameLen), string(p + nameLen, pwdLen));
+        pos += HEAD_SIZE + nameLen + pwdLen;
+    }
+    return pos;
+}
+
+bool LocalAuthStore::Find(const string& name, string* password, bool* found) {
+    lock_guard<mutex> locker(mtx_);
+    auto it = users_.find(name);
+    *found = (it != users_.end());
+    if(*found) { *password = it->second; }
+    return true;
+}
+
+// 先追加到文件再更新内存，写文件失败时不登记用户；写入只进入页缓存，不等待落盘
+bool LocalAuthStore::Insert(const string& name, const string& password) {
+    if(name.size() > MAX_FIELD || password.size() > MAX_FIELD) { return false; }
+    string rec(HEAD_SIZE, '\0');
+    uint16_t nameLen = name.size(), pwdLen = password.size();
+    memcpy(&rec[0], &nameLen, 2);
+    memcpy(&rec[2], &pwdLen, 2);
+    rec += name;
+    rec += password;
+    lock_guard<mutex> locker(mtx_);
+    assert(fd_ >= 0);
+    if(users_.count(name)) { return false; }
+    ssize_t n = write(fd_, rec.data(), rec.size());
+    if(n != static_cast<ssize_t>(rec.size())) {
+        LOG_ERROR("Local auth store write error: %s", n < 0 ? strerror(errno) : "short write");
+        if(n > 0) { // 去掉写了一半的记录，保持文件可重放
+            struct stat st;
+            if(fstat(fd_, &st) == 0 && ftruncate(fd_, st.st_size - n) < 0) { LOG_ERROR("Local auth store truncate error"); }
+        }
+        return false;
+    }
+    users_.emplace(name, password);
+    return true;
+}
+
+size_t LocalAuthStore::Size() {
+    lock_guard<mutex> locker(mtx_);
+    return users_.size();
+}
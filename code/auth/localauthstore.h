@@ -0,0 +1,54 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#ifndef LOCALAUTHSTORE_H
+#define LOCALAUTHSTORE_H
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <fcntl.h>       // open
+#include <unistd.h>      // write, close, ftruncate
+#include <sys/mman.h>    // mmap
+#include <sys/stat.h>    // fstat
+#include <errno.h>
+#include <assert.h>
+#include <string.h>      // memcpy
+#include <stdint.h>
+#include "authstore.h"
+#include "../log/log.h"
+
+// 本地文件用户存储：不依赖数据库，用于测试、压测与不需要 MySQL 的部署。
+// 文件是只追加的记录序列，每条记录为 2 字节用户名长度、2 字节密码长度与两段内容；
+// 打开时 mmap 整个文件重放到内存哈希表，注册时一次 write 追加一条记录。
+// 末尾不完整的记录（写入中途进程退出）在打开时截掉
+class LocalAuthStore : public AuthStore {
+public:
+    LocalAuthStore();
+
+    ~LocalAuthStore();
+
+    bool Open(const std::string& path, std::string* err);
+
+    bool Find(const std::string& name, std::string* password, bool* found) override;
+
+    bool Insert(const std::string& name, const std::string& password) override;
+
+    const char* Name() const override { return "local"; }
+
+    size_t Size();
+
+private:
+    static const size_t HEAD_SIZE = 4;
+    static const size_t MAX_FIELD = 0xffff;
+
+    size_t Load_(const char* data, size_t size);
+
+    int fd_;
+    std::mutex mtx_;
+    std::unordered_map<std::string, std::string> users_;
+};
+
+#endif //LOCALAUTHSTORE_H
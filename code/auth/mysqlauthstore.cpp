@@ -0,0 +1,161 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#include "mysqlauthstore.h"
+
+using namespace std;
+
+// 用户表的查询与插入语句，在每个连接上预处理一次后复用，参数以二进制方式绑定，不拼接 SQL
+static const string QUERY_USER_SQL = "SELECT password FROM user WHERE username = ? LIMIT 1";
+static const string INSERT_USER_SQL = "INSERT INTO user(username, password) VALUES(?, ?)";
+static const string QUERY_USERS_SQL = "SELECT username FROM user WHERE username IN ("; // 按批量大小补齐参数
+
+MysqlAuthStore::MysqlAuthStore(const char* host, int port, const char* user, const char* pwd,
+                               const char* dbName, int minConn, int maxConn, int waitMs) {
+    SqlConnPool::Instance()->Init(host, port, user, pwd, dbName, minConn, maxConn, waitMs); // 创建一个数据库连接池
+}
+
+MysqlAuthStore::~MysqlAuthStore() {
+    SqlConnPool::Instance()->ClosePool(); // 关闭数据库连接池
+}
+
+bool MysqlAuthStore::Find(const string& name, string* password, bool* found) {
+    SqlConn *conn = nullptr;
+    SqlConnRAII raii(&conn, SqlConnPool::Instance());
+    if (!conn) { return false; }
+    MYSQL_STMT *query = conn->Prepare(QUERY_USER_SQL);
+    if (!query) { return false; }
+    MYSQL_BIND param[1];
+    unsigned long nameLen = name.size();
+    SqlConn::BindString(param[0], const_cast<char *>(name.data()), nameLen, &nameLen);
+    char buff[160];//password 列为 varchar(128)，保存 scrypt 哈希记录，超出缓冲区时 fetch 返回 MYSQL_DATA_TRUNCATED
+    unsigned long len = 0;
+    MYSQL_BIND result[1];
+    SqlConn::BindString(result[0], buff, sizeof(buff), &len);
+    if (mysql_stmt_bind_param(query, param) || mysql_stmt_execute(query)
+        || mysql_stmt_bind_result(query, result) || mysql_stmt_store_result(query)) {
+        LOG_ERROR("Query user error: %s", mysql_stmt_error(query));
+        conn->Discard(QUERY_USER_SQL);
+        return false;
+    }
+    int ret = mysql_stmt_fetch(query);
+    if (ret == 1) { // 取结果出错，不能当作用户不存在，否则会缓存错误的否定结果
+        LOG_ERROR("Fetch user error: %s", mysql_stmt_error(query));
+        conn->Discard(QUERY_USER_SQL);
+        return false;
+    }
+    mysql_stmt_free_result(query);
+    if (ret == MYSQL_DATA_TRUNCATED) { // 表结构与预期不符，不把截断的记录当作密码
+        LOG_ERROR("Password of %s truncated", name.c_str());
+        return false;
+    }
+    *found = (ret != MYSQL_NO_DATA);
+    if (*found) { password->assign(buff, len); }
+    return true;
+}
+
+bool MysqlAuthStore::Insert(const string& name, const string& password) {
+    SqlConn *conn = nullptr;
+    SqlConnRAII raii(&conn, SqlConnPool::Instance());
+    if (!conn) { return false; }
+    return InsertOne_(conn, name, password);
+}
+
+// 批量注册：一次查询找出已存在的用户，再用一条多行 INSERT 写入其余用户，整批只需两次往返。
+// 用户名上有唯一键，查询之后其他进程抢先插入同名用户时整条 INSERT 失败，此时逐个插入区分成败
+void MysqlAuthStore::InsertBatch(const vector<pair<string, string>>& users, vector<bool>* ok) {
+    ok->assign(users.size(), false);
+    vector<size_t> unique; // 批内第一次出现的用户名
+    unordered_set<string> seen;
+    for (size_t i = 0; i < users.size(); i++) {
+        if (seen.insert(users[i].first).second) { unique.push_back(i); }
+    }
+    if (unique.empty()) { return; }
+    SqlConn *conn = nullptr;
+    SqlConnRAII raii(&conn, SqlConnPool::Instance());
+    if (!conn) { return; }
+
+    /* 查询已存在的用户 */
+    string querySql = QUERY_USERS_SQL + "?";
+    for (size_t i = 1; i < unique.size(); i++) { querySql += ", ?"; }
+    querySql += ")";
+    MYSQL_STMT *query = conn->Prepare(querySql);
+    if (!query) { return; }
+    vector<MYSQL_BIND> param(unique.size() * 2);
+    vector<unsigned long> lens(unique.size() * 2);
+    for (size_t k = 0; k < unique.size(); k++) {
+        const string& name = users[unique[k]].first;
+        lens[k] = name.size();
+        SqlConn::BindString(param[k], const_cast<char *>(name.data()), lens[k], &lens[k]);
+    }
+    char buff[64];
+    unsigned long len = 0;
+    MYSQL_BIND result[1];
+    SqlConn::BindString(result[0], buff, sizeof(buff), &len);
+    if (mysql_stmt_bind_param(query, param.data()) || mysql_stmt_execute(query)
+        || mysql_stmt_bind_result(query, result) || mysql_stmt_store_result(query)) {
+        LOG_ERROR("Query users error: %s", mysql_stmt_error(query));
+        conn->Discard(querySql);
+        return;
+    }
+    unordered_set<string> existing;
+    int ret;
+    while ((ret = mysql_stmt_fetch(query)) == 0 || ret == MYSQL_DATA_TRUNCATED) {
+        existing.insert(string(buff, min<unsigned long>(len, sizeof(buff))));
+    }
+    if (ret == 1) { // 已有用户没有取全，整批按失败处理
+        LOG_ERROR("Fetch users error: %s", mysql_stmt_error(query));
+        conn->Discard(querySql);
+        return;
+    }
+    mysql_stmt_free_result(query);
+    vector<size_t> fresh;
+    for (size_t i : unique) {
+        if (!existing.count(users[i].first)) { fresh.push_back(i); }
+    }
+    if (fresh.empty()) { return; }
+
+    /* 一条语句写入其余用户 */
+    string insertSql = INSERT_USER_SQL;
+    for (size_t i = 1; i < fresh.size(); i++) { insertSql += ", (?, ?)"; }
+    MYSQL_STMT *insert = conn->Prepare(insertSql);
+    if (!insert) { return; }
+    for (size_t k = 0; k < fresh.size(); k++) {
+        const pair<string, string>& user = users[fresh[k]];
+        lens[2 * k] = user.first.size();
+        lens[2 * k + 1] = user.second.size();
+        SqlConn::BindString(param[2 * k], const_cast<char *>(user.first.data()), lens[2 * k], &lens[2 * k]);
+        SqlConn::BindString(param[2 * k + 1], const_cast<char *>(user.second.data()), lens[2 * k + 1], &lens[2 * k + 1]);
+    }
+    if (!mysql_stmt_bind_param(insert, param.data()) && !mysql_stmt_execute(insert)) {
+        for (size_t i : fresh) { (*ok)[i] = true; }
+        return;
+    }
+    if (mysql_stmt_errno(insert) != ER_DUP_ENTRY) {
+        LOG_ERROR("Insert users error: %s", mysql_stmt_error(insert));
+        conn->Discard(insertSql);
+        return;
+    }
+    for (size_t i : fresh) { (*ok)[i] = InsertOne_(conn, users[i].first, users[i].second); }
+}
+
+bool MysqlAuthStore::InsertOne_(SqlConn *conn, const string& name, const string& password) {
+    MYSQL_STMT *insert = conn->Prepare(INSERT_USER_SQL);
+    if (!insert) { return false; }
+    MYSQL_BIND param[2];
+    unsigned long nameLen = name.size(), pwdLen = password.size();
+    SqlConn::BindString(param[0], const_cast<char *>(name.data()), nameLen, &nameLen);
+    SqlConn::BindString(param[1], const_cast<char *>(password.data()), pwdLen, &pwdLen);
+    if (mysql_stmt_bind_param(insert, param) || mysql_stmt_execute(insert)) {
+        if (mysql_stmt_errno(insert) == ER_DUP_ENTRY) { // 用户名已被注册
+            LOG_DEBUG("user used!");
+            return false;
+        }
+        LOG_ERROR("Insert error: %s", mysql_stmt_error(insert));
+        conn->Discard(INSERT_USER_SQL);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,37 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#ifndef MYSQLAUTHSTORE_H
+#define MYSQLAUTHSTORE_H
+
+#include <unordered_set>
+#include <algorithm>            // min
+#include <mysql/mysqld_error.h> // ER_DUP_ENTRY
+#include "authstore.h"
+#include "../log/log.h"
+#include "../pool/sqlconnpool.h"
+#include "../pool/sqlconnRAII.h"
+
+// 基于 MySQL user 表的用户存储，构造时初始化数据库连接池，析构时关闭
+class MysqlAuthStore : public AuthStore {
+public:
+    MysqlAuthStore(const char* host, int port, const char* user, const char* pwd,
+                   const char* dbName, int minConn, int maxConn, int waitMs);
+
+    ~MysqlAuthStore();
+
+    bool Find(const std::string& name, std::string* password, bool* found) override;
+
+    bool Insert(const std::string& name, const std::string& password) override;
+
+    void InsertBatch(const std::vector<std::pair<std::string, std::string>>& users, std::vector<bool>* ok) override;
+
+    const char* Name() const override { return "mysql"; }
+
+private:
+    static bool InsertOne_(SqlConn* conn, const std::string& name, const std::string& password);
+};
+
+#endif //MYSQLAUTHSTORE_H
@@ -0,0 +1,76 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#include "passwordhasher.h"
+
+using namespace std;
+
+// 用随机盐计算 pwd 的哈希记录，失败（随机数或 scrypt 出错）返回 false
+bool PasswordHasher::Hash(const string& pwd, string* record) {
+    unsigned char salt[SALT_LEN], key[KEY_LEN];
+    if(RAND_bytes(salt, SALT_LEN) != 1) { return false; }
+    if(!Derive_(pwd, salt, SALT_LEN, LOG_N, R, P, key, KEY_LEN)) { return false; }
+    *record = "scrypt$" + to_string(LOG_N) + "$" + to_string(R) + "$" + to_string(P) + "$"
+              + ToHex(salt, SALT_LEN) + "$" + ToHex(key, KEY_LEN);
+    return true;
+}
+
+// 按记录中的参数重新计算并比较，比较时间与内容无关。
+// 不以 scrypt$ 开头的记录是引入哈希之前注册的明文密码，按明文比较
+bool PasswordHasher::Verify(const string& pwd, const string& record) {
+    if(record.compare(0, 7, "scrypt$") != 0) {
+        return record.size() == pwd.size() && CRYPTO_memcmp(record.data(), pwd.data(), pwd.size()) == 0;
+    }
+    string field[5];
+    size_t pos = 7;
+    for(int i = 0; i < 5; i++) {
+        size_t end = (i == 4) ? record.size() : record.find('$', pos);
+        if(end == string::npos) { return false; }
+        field[i] = record.substr(pos, end - pos);
+        pos = end + 1;
+    }
+    int logN = atoi(field[0].c_str()), r = atoi(field[1].c_str()), p = atoi(field[2].c_str());
+    if(logN < 1 || logN > MAX_LOG_N || r < 1 || p < 1 || r > MAX_RP || p > MAX_RP || r * p > MAX_RP) { return false; }
+    unsigned char salt[64], stored[64], key[64];
+    size_t saltLen = field[3].size() / 2, keyLen = field[4].size() / 2;
+    if(saltLen == 0 || saltLen > sizeof(salt) || keyLen == 0 || keyLen > sizeof(key)
+       || !FromHex(field[3], salt, saltLen) || !FromHex(field[4], stored, keyLen)) {
+        return false;
+    }
+    if(!Derive_(pwd, salt, saltLen, logN, r, p, key, keyLen)) { return false; }
+    return CRYPTO_memcmp(key, stored, keyLen) == 0;
+}
+
+bool PasswordHasher::Derive_(const string& pwd, const unsigned char* salt, size_t saltLen,
+                             int logN, int r, int p, unsigned char* key, size_t keyLen) {
+    uint64_t n = 1ULL << logN;
+    uint64_t maxMem = 128ULL * r * (n + p + 2); // scrypt 需要的内存，默认上限 32MB 不够 MAX_LOG_N 使用
+    return EVP_PBE_scrypt(pwd.data(), pwd.size(), salt, saltLen, n, r, p, maxMem, key, keyLen) == 1;
+}
+
+string PasswordHasher::ToHex(const unsigned char* data, size_t len) {
+    static const char* digits = "0123456789abcdef";
+    string hex(len * 2, '0');
+    for(size_t i = 0; i < len; i++) {
+        hex[2 * i] = digits[data[i] >> 4];
+        hex[2 * i + 1] = digits[data[i] & 0xf];
+    }
+    return hex;
+}
+
+// 解析 2 * len 个十六进制字符
+bool PasswordHasher::FromHex(const string& hex, unsigned char* out, size_t len) {
+    if(hex.size() != len * 2) { return false; }
+    for(size_t i = 0; i < len * 2; i++) {
+        char c = hex[i];
+        int v;
+        if(c >= '0' && c <= '9') { v = c - '0'; }
+        else if(c >= 'a' && c <= 'f') { v = c - 'a' + 10; }
+        else { return false; }
+        if(i % 2 == 0) { out[i / 2] = v << 4; }
+        else { out[i / 2] |= v; }
+    }
+    return true;
+}
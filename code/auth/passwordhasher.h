@@ -0,0 +1,42 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#ifndef PASSWORDHASHER_H
+#define PASSWORDHASHER_H
+
+#include <string>
+#include <stdint.h>
+#include <stdlib.h>         // atoi
+#include <openssl/evp.h>    // EVP_PBE_scrypt
+#include <openssl/rand.h>   // RAND_bytes
+#include <openssl/crypto.h> // CRYPTO_memcmp
+
+// scrypt 密码哈希（内存密集，抵抗 GPU 暴力破解），保存为
+// scrypt$<log2 N>$<r>$<p>$<盐 hex>$<哈希 hex>。
+// 一次哈希约占 128 * r * N 字节内存与数十毫秒 CPU，只应在 CpuExecutor 中调用，不能放在处理请求的线程里
+class PasswordHasher {
+public:
+    static const int LOG_N = 14;      // N = 16384，约 16MB 内存
+    static const int R = 8;
+    static const int P = 1;
+    static const int MAX_LOG_N = 16;  // 校验时接受的最大代价，异常记录不能让一次校验占用过多内存与 CPU
+    static const int MAX_RP = 16;     // 校验时接受的最大 r * p
+    static const int SALT_LEN = 16;
+    static const int KEY_LEN = 32;
+
+    static bool Hash(const std::string& pwd, std::string* record);
+
+    static bool Verify(const std::string& pwd, const std::string& record);
+
+    static std::string ToHex(const unsigned char* data, size_t len);
+
+    static bool FromHex(const std::string& hex, unsigned char* out, size_t len);
+
+private:
+    static bool Derive_(const std::string& pwd, const unsigned char* salt, size_t saltLen,
+                        int logN, int r, int p, unsigned char* key, size_t keyLen);
+};
+
+#endif //PASSWORDHASHER_H
@@ -0,0 +1,82 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#include "registerbatcher.h"
+
+using namespace std;
+
+RegisterBatcher::RegisterBatcher(AuthStore* store, DoneCallback done, size_t maxBatch, int flushMs, size_t maxPending)
+    : store_(store), done_(move(done)), maxBatch_(maxBatch), flushUs_(static_cast<int64_t>(flushMs) * 1000),
+      maxPending_(maxPending), isClosed_(false) {
+    assert(store_ && done_ && maxBatch_ > 0 && flushMs >= 0 && maxPending_ > 0);
+    batchSize_ = MetricsRegistry::Instance()->GetHistogram(
+        "webserver_register_batch_size", "Registrations written per batch.", "", 1);
+    thread_ = thread(&RegisterBatcher::Run_, this);
+}
+
+// 析构函数：写完已入队的注册后退出
+RegisterBatcher::~RegisterBatcher() {
+    {
+        lock_guard<mutex> locker(mtx_);
+        isClosed_ = true;
+    }
+    cond_.notify_one();
+    thread_.join();
+}
+
+// 注册请求入队，队列已满或已关闭时返回 false，调用方按注册失败处理
+bool RegisterBatcher::Submit(uint64_t connId, const string& name, const string& pwd) {
+    size_t size;
+    {
+        lock_guard<mutex> locker(mtx_);
+        if(isClosed_ || pending_.size() >= maxPending_) { return false; }
+        pending_.push_back({ connId, name, pwd, MetricsNowUs() });
+        size = pending_.size();
+    }
+    if(size == 1 || size == maxBatch_) { cond_.notify_one(); } // 开始计时或攒够一批时唤醒
+    return true;
+}
+
+size_t RegisterBatcher::QueueSize() {
+    lock_guard<mutex> locker(mtx_);
+    return pending_.size();
+}
+
+// 后台线程：最早的请求等待满 flushUs_、攒够一批或关闭时写入一批
+void RegisterBatcher::Run_() {
+    vector<Item> batch;
+    vector<pair<string, string>> users;
+    vector<bool> ok;
+    unique_lock<mutex> locker(mtx_);
+    while(true) {
+        if(pending_.empty()) {
+            if(isClosed_) { break; }
+            cond_.wait(locker);
+            continue;
+        }
+        int64_t wait = pending_.front().enqueueUs + flushUs_ - MetricsNowUs();
+        if(pending_.size() < maxBatch_ && !isClosed_ && wait > 0) {
+            cond_.wait_for(locker, chrono::microseconds(wait));
+            continue;
+        }
+        batch.clear();
+        while(!pending_.empty() && batch.size() < maxBatch_) {
+            batch.push_back(move(pending_.front()));
+            pending_.pop_front();
+        }
+        locker.unlock();
+        users.clear();
+        for(const Item& item : batch) { users.emplace_back(item.name, item.pwd); }
+        int64_t startUs = MetricsNowUs();
+        store_->InsertBatch(users, &ok);
+        int64_t doneUs = MetricsNowUs();
+        batchSize_->Record(batch.size());
+        for(size_t i = 0; i < batch.size(); i++) {
+            if(ok[i]) { UserCache::Instance()->Put(batch[i].name, batch[i].pwd); } // 注册成功后同步写入缓存
+            done_(batch[i].connId, ok[i], startUs, doneUs);
+        }
+        locker.lock();
+    }
+}
@@ -0,0 +1,61 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#ifndef REGISTERBATCHER_H
+#define REGISTERBATCHER_H
+
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+#include <string>
+#include <thread>
+#include <chrono>
+#include <functional>
+#include <assert.h>
+#include "authstore.h"
+#include "usercache.h"
+#include "../metrics/metrics.h"
+
+// 注册的写后队列：注册请求只入队，后台线程攒够 maxBatch 个或最早的请求等待满 flushMs 后
+// 调用 AuthStore::InsertBatch 一次写入，再通过回调把每个请求的结果交回；
+// 注册高峰时数据库往返次数按批摊薄。队列超过 maxPending 时拒绝入队
+class RegisterBatcher {
+public:
+    // 一个注册请求完成：连接 id、是否成功、本批开始与结束写入的单调时钟时间（微秒）
+    typedef std::function<void(uint64_t connId, bool ok, int64_t startUs, int64_t doneUs)> DoneCallback;
+
+    RegisterBatcher(AuthStore* store, DoneCallback done, size_t maxBatch = 32, int flushMs = 5, size_t maxPending = 4096);
+
+    ~RegisterBatcher();
+
+    bool Submit(uint64_t connId, const std::string& name, const std::string& pwd);
+
+    size_t QueueSize();
+
+private:
+    struct Item {
+        uint64_t connId;
+        std::string name;
+        std::string pwd;
+        int64_t enqueueUs;
+    };
+
+    void Run_();
+
+    AuthStore* store_;
+    DoneCallback done_;
+    size_t maxBatch_;
+    int64_t flushUs_;
+    size_t maxPending_;
+    bool isClosed_;
+    std::mutex mtx_;
+    std::condition_variable cond_;
+    std::deque<Item> pending_;
+    std::thread thread_;
+    Histogram* batchSize_;
+};
+
+#endif //REGISTERBATCHER_H
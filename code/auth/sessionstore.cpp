@@ -0,0 +1,250 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#include "sessionstore.h"
+
+using namespace std;
+
+const char* SessionStore::COOKIE_NAME = "sid";
+
+namespace {
+const char MAGIC[8] = { 'W', 'S', 'S', 'E', 'S', 'S', '0', '1' };
+}
+
+// ttlSec 为会话有效期，capacity 为会话总数上限，平均分到各分片，分片满时淘汰最早创建的会话
+SessionStore::SessionStore(int ttlSec, size_t capacity)
+    : ttlSec_(ttlSec), shardCapacity_(capacity / SHARDS > 0 ? capacity / SHARDS : 1), fd_(-1), fileBytes_(0),
+      liveBytes_(0) {
+    assert(ttlSec > 0);
+    if(RAND_bytes(key_, KEY_LEN) != 1) { // 随机数不可用时签发的会话不安全，直接终止
+        LOG_ERROR("SessionStore: RAND_bytes failed");
+        abort();
+    }
+    MetricsRegistry* reg = MetricsRegistry::Instance();
+    hits_ = reg->GetCounter("webserver_session_checks_total", "Session cookie checks.", "result=\"hit\"");
+    misses_ = reg->GetCounter("webserver_session_checks_total", "Session cookie checks.", "result=\"miss\"");
+}
+
+SessionStore::~SessionStore() {
+    if(fd_ >= 0) { close(fd_); }
+}
+
+// 打开（不存在时创建）会话文件：载入签名密钥与未过期的会话，
+// 再把它们写入临时文件并替换原文件，去掉已过期的记录后以追加方式继续写入
+bool SessionStore::Open(const string& path, string* err) {
+    lock_guard<mutex> fileLocker(fileMtx_);
+    assert(fd_ < 0);
+    int fd = open(path.c_str(), O_RDONLY | O_CREAT | O_CLOEXEC, 0600);
+    if(fd < 0) {
+        *err = "cannot open " + path + ": " + strerror(errno);
+        return false;
+    }
+    struct stat st;
+    if(fstat(fd, &st) < 0) {
+        *err = "cannot stat " + path + ": " + strerror(errno);
+        close(fd);
+        return false;
+    }
+    size_t size = st.st_size;
+    if(size > 0) {
+        void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(data == MAP_FAILED) {
+            *err = "cannot mmap " + path + ": " + strerror(errno);
+            close(fd);
+            return false;
+        }
+        const char* p = static_cast<const char*>(data);
+        if(size < HEAD_SIZE || memcmp(p, MAGIC, sizeof(MAGIC)) != 0) {
+            munmap(data, size);
+            close(fd);
+            *err = path + " is not a session file";
+            return false;
+        }
+        memcpy(key_, p + sizeof(MAGIC), KEY_LEN);
+        size_t valid = Load_(p, size, time(nullptr));
+        if(valid < size) { LOG_WARN("%s: dropped %zu trailing bytes of a partial record", path.c_str(), size - valid); }
+        munmap(data, size);
+    }
+    close(fd);
+    path_ = path;
+    if(!Rewrite_(err)) { return false; }
+    LOG_INFO("Session store %s: %zu sessions", path.c_str(), Size());
+    return true;
+}
+
+// 重放记录，返回完整记录占用的字节数，已过期的会话不载入
+size_t SessionStore::Load_(const char* data, size_t size, int64_t now) {
+    size_t pos = HEAD_SIZE;
+    while(size - pos >= REC_HEAD) {
+        uint16_t userLen;
+        int64_t expires;
+        memcpy(&userLen, data + pos, 2);
+        memcpy(&expires, data + pos + 2 + ID_LEN, 8);
+        if(size - pos - REC_HEAD < userLen) { break; }
+        if(expires > now) {
+            const unsigned char* id = reinterpret_cast<const unsigned char*>(data + pos + 2);
+            Insert_(PasswordHasher::ToHex(id, ID_LEN), string(data + pos + REC_HEAD, userLen), expires);
+        }
+        pos += REC_HEAD + userLen;
+    }
+    return pos;
+}
+
+// 为 user 签发一个会话，返回 cookie 的值，失败时返回空串。
+// 持久化时一次 write 追加一条记录，写入失败只记录日志，会话在本次运行中仍然有效；
+// 追加与插入在 fileMtx_ 下完成，重写文件时不会漏掉正在签发的会话
+string SessionStore::Create(const string& user) {
+    unsigned char id[ID_LEN];
+    if(user.empty() || user.size() > MAX_USER || RAND_bytes(id, ID_LEN) != 1) { return ""; }
+    int64_t expires = time(nullptr) + ttlSec_;
+    string hex = PasswordHasher::ToHex(id, ID_LEN);
+    {
+        lock_guard<mutex> fileLocker(fileMtx_);
+        if(fd_ >= 0) {
+            string rec = Record_(id, user, expires);
+            ssize_t n = write(fd_, rec.data(), rec.size());
+            if(n != static_cast<ssize_t>(rec.size())) {
+                LOG_ERROR("Session store write error: %s", strerror(errno));
+            }
+            if(n > 0) { fileBytes_ += n; }
+        }
+        Insert_(hex, user, expires);
+    }
+    return hex + "." + Sign_(hex);
+}
+
+// 校验 cookie 的值，有效时返回 true 并给出用户名；签名不符的不查表
+bool SessionStore::Check(StrView token, string* user) {
+    assert(user);
+    if(token.len != TOKEN_LEN || token.data[ID_LEN * 2] != '.') {
+        misses_->Inc();
+        return false;
+    }
+    string id(token.data, ID_LEN * 2);
+    string mac = Sign_(id);
+    if(CRYPTO_memcmp(mac.data(), token.data + ID_LEN * 2 + 1, mac.size()) != 0) {
+        misses_->Inc();
+        return false;
+    }
+    Shard& shard = ShardOf_(id);
+    {
+        lock_guard<mutex> locker(shard.mtx);
+        auto it = shard.items.find(id);
+        if(it != shard.items.end() && it->second.expires > time(nullptr)) {
+            *user = it->second.user;
+            hits_->Inc();
+            return true;
+        }
+    }
+    misses_->Inc();
+    return false;
+}
+
+// 清理已过期的会话，返回清理的数量；由事件循环的定时器周期性调用，每个分片只检查队首。
+// 持久化时，文件中失效记录的字节数超过有效会话时重写文件
+size_t SessionStore::Expire() {
+    int64_t now = time(nullptr);
+    size_t removed = 0;
+    for(auto& shard : shards_) {
+        lock_guard<mutex> locker(shard.mtx);
+        while(!shard.order.empty() && shard.order.front().first <= now) {
+            auto it = shard.items.find(shard.order.front().second);
+            if(it != shard.items.end() && it->second.expires <= now) {
+                liveBytes_ -= RecordSize_(it->second.user);
+                shard.items.erase(it);
+                removed++;
+            }
+            shard.order.pop_front();
+        }
+    }
+    lock_guard<mutex> fileLocker(fileMtx_);
+    size_t live = HEAD_SIZE + liveBytes_;
+    if(fd_ >= 0 && fileBytes_ >= COMPACT_MIN_BYTES && fileBytes_ > 2 * live) {
+        size_t before = fileBytes_;
+        string err;
+        if(Rewrite_(&err)) {
+            LOG_INFO("Session store %s compacted: %zu -> %zu bytes", path_.c_str(), before, fileBytes_);
+        } else {
+            LOG_ERROR("Session store compaction failed: %s", err.c_str());
+        }
+    }
+    return removed;
+}
+
+size_t SessionStore::Size() {
+    size_t n = 0;
+    for(auto& shard : shards_) {
+        lock_guard<mutex> locker(shard.mtx);
+        n += shard.items.size();
+    }
+    return n;
+}
+
+// 插入一个会话，分片满时先淘汰最早创建的会话
+void SessionStore::Insert_(const string& id, const string& user, int64_t expires) {
+    Shard& shard = ShardOf_(id);
+    lock_guard<mutex> locker(shard.mtx);
+    while(shard.items.size() >= shardCapacity_ && !shard.order.empty()) {
+        auto it = shard.items.find(shard.order.front().second);
+        if(it != shard.items.end()) {
+            liveBytes_ -= RecordSize_(it->second.user);
+            shard.items.erase(it);
+        }
+        shard.order.pop_front();
+    }
+    auto it = shard.items.find(id);
+    if(it != shard.items.end()) { liveBytes_ -= RecordSize_(it->second.user); }
+    liveBytes_ += RecordSize_(user);
+    shard.items[id] = { user, expires };
+    shard.order.emplace_back(expires, id);
+}
+
+// 会话 id 的签名：HMAC-SHA256 截取前 MAC_LEN 字节
+string SessionStore::Sign_(const string& id) const {
+    unsigned char mac[EVP_MAX_MD_SIZE];
+    unsigned int len = 0;
+    HMAC(EVP_sha256(), key_, KEY_LEN, reinterpret_cast<const unsigned char*>(id.data()), id.size(), mac, &len);
+    assert(len >= static_cast<unsigned int>(MAC_LEN));
+    return PasswordHasher::ToHex(mac, MAC_LEN);
+}
+
+// 一条持久化记录：2 字节用户名长度、会话 id、8 字节过期时间与用户名
+string SessionStore::Record_(const unsigned char* id, const string& user, int64_t expires) {
+    string rec(REC_HEAD, '\0');
+    uint16_t userLen = user.size();
+    memcpy(&rec[0], &userLen, 2);
+    memcpy(&rec[2], id, ID_LEN);
+    memcpy(&rec[2 + ID_LEN], &expires, 8);
+    rec += user;
+    return rec;
+}
+
+// 把签名密钥与当前的会话写入临时文件，替换 path_ 后在新文件上继续追加；调用方持有 fileMtx_。
+// 失败时原文件与 fd_ 保持不变
+bool SessionStore::Rewrite_(string* err) {
+    string content(MAGIC, sizeof(MAGIC));
+    content.append(reinterpret_cast<const char*>(key_), KEY_LEN);
+    for(auto& shard : shards_) {
+        lock_guard<mutex> locker(shard.mtx);
+        for(auto& kv : shard.items) {
+            unsigned char id[ID_LEN];
+            PasswordHasher::FromHex(kv.first, id, ID_LEN);
+            content += Record_(id, kv.second.user, kv.second.expires);
+        }
+    }
+    string tmp = path_ + ".tmp";
+    int fd = open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0600);
+    if(fd < 0 || write(fd, content.data(), content.size()) != static_cast<ssize_t>(content.size())
+       || rename(tmp.c_str(), path_.c_str()) < 0) {
+        *err = "cannot rewrite " + path_ + ": " + strerror(errno);
+        if(fd >= 0) { close(fd); }
+        unlink(tmp.c_str());
+        return false;
+    }
+    if(fd_ >= 0) { close(fd_); }
+    fd_ = fd; // 以追加方式打开的临时文件改名后即为新的会话文件
+    fileBytes_ = content.size();
+    return true;
+}
@@ -0,0 +1,106 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#ifndef SESSIONSTORE_H
+#define SESSIONSTORE_H
+
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <deque>
+#include <unordered_map>
+#include <functional>
+#include <time.h>           // time
+#include <fcntl.h>          // open
+#include <unistd.h>         // write, close, rename
+#include <sys/mman.h>       // mmap
+#include <sys/stat.h>       // fstat
+#include <errno.h>
+#include <assert.h>
+#include <string.h>         // memcpy
+#include <stdint.h>
+#include <openssl/hmac.h>   // HMAC
+#include <openssl/rand.h>   // RAND_bytes
+#include <openssl/crypto.h> // CRYPTO_memcmp
+#include "passwordhasher.h"
+#include "../buffer/strview.h"
+#include "../log/log.h"
+#include "../metrics/metrics.h"
+
+// 会话存储：登录或注册成功后签发会话，cookie 为 <会话 id hex>.<HMAC-SHA256 签名 hex>。
+// 校验先比较签名（伪造的 cookie 不查表），再在按 id 分片的内存表中查找用户与过期时间，全程不访问数据库。
+// 过期由事件循环的定时器周期性调用 Expire() 清理；每个分片按创建顺序排队，有效期相同时队首最早过期。
+// 可选地把签名密钥与会话追加写入本地文件，重启后仍然有效；文件中失效的记录多于有效的记录时，
+// 由 Expire() 把有效的会话重写为新文件，文件大小与会话数同量级
+class SessionStore {
+public:
+    static const int SHARDS = 16;
+    static const char* COOKIE_NAME;
+
+    SessionStore(int ttlSec, size_t capacity);
+
+    ~SessionStore();
+
+    bool Open(const std::string& path, std::string* err);
+
+    std::string Create(const std::string& user);
+
+    bool Check(StrView token, std::string* user);
+
+    size_t Expire();
+
+    size_t Size();
+
+    int TtlSec() const { return ttlSec_; }
+
+private:
+    static const int ID_LEN = 16;    // 会话 id 字节数
+    static const int MAC_LEN = 16;   // 截取的签名字节数
+    static const int KEY_LEN = 32;   // 签名密钥字节数
+    static const size_t TOKEN_LEN = ID_LEN * 2 + 1 + MAC_LEN * 2;
+    static const size_t HEAD_SIZE = 8 + KEY_LEN;            // 文件头：魔数与签名密钥
+    static const size_t REC_HEAD = 2 + ID_LEN + 8;          // 记录头：用户名长度、会话 id、过期时间
+    static const size_t MAX_USER = 0xffff;
+    static const size_t COMPACT_MIN_BYTES = 64 * 1024; // 文件小于此大小时不压缩
+
+    struct Session {
+        std::string user;
+        int64_t expires; // 过期时间（墙上时钟，秒），需要跨重启保存
+    };
+
+    struct Shard {
+        std::mutex mtx;
+        std::unordered_map<std::string, Session> items; // 键为会话 id 的 hex
+        std::deque<std::pair<int64_t, std::string>> order; // 按创建顺序的（过期时间，id）
+    };
+
+    Shard& ShardOf_(const std::string& id) { return shards_[std::hash<std::string>()(id) % SHARDS]; }
+
+    static size_t RecordSize_(const std::string& user) { return REC_HEAD + user.size(); }
+
+    void Insert_(const std::string& id, const std::string& user, int64_t expires);
+
+    std::string Sign_(const std::string& id) const;
+
+    size_t Load_(const char* data, size_t size, int64_t now);
+
+    static std::string Record_(const unsigned char* id, const std::string& user, int64_t expires);
+
+    bool Rewrite_(std::string* err);
+
+    int ttlSec_;
+    size_t shardCapacity_;
+    unsigned char key_[KEY_LEN]; // 签名密钥，不持久化时每次启动随机生成
+    std::string path_; // 持久化文件路径
+    std::mutex fileMtx_; // 保护 fd_ 与 fileBytes_，追加记录与重写文件互斥
+    int fd_; // 持久化文件，-1 表示不持久化
+    size_t fileBytes_; // 持久化文件的大小
+    std::atomic<size_t> liveBytes_; // 内存中的会话按记录格式占用的字节数
+    Shard shards_[SHARDS];
+    Counter* hits_;
+    Counter* misses_;
+};
+
+#endif //SESSIONSTORE_H
@@ -0,0 +1,102 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#include "usercache.h"
+
+using namespace std;
+
+// capacity 为总条目上限，平均分到各分片；ttlMs 为已存在用户的有效期，negativeTtlMs 为不存在用户的有效期
+UserCache::UserCache(size_t capacity, int ttlMs, int negativeTtlMs)
+    : shardCapacity_(capacity / SHARDS > 0 ? capacity / SHARDS : 1),
+      ttlUs_(static_cast<int64_t>(ttlMs) * 1000), negativeTtlUs_(static_cast<int64_t>(negativeTtlMs) * 1000) {
+    assert(ttlMs > 0 && negativeTtlMs >= 0);
+    MetricsRegistry* reg = MetricsRegistry::Instance();
+    hits_ = reg->GetCounter("webserver_user_cache_lookups_total", "User credential cache lookups.", "result=\"hit\"");
+    misses_ = reg->GetCounter("webserver_user_cache_lookups_total", "User credential cache lookups.", "result=\"miss\"");
+}
+
+// 登录注册使用的全局缓存：最多 10000 个用户，存在的用户缓存 60 秒，不存在的缓存 5 秒
+UserCache* UserCache::Instance() {
+    static UserCache cache(10000, 60000, 5000);
+    return &cache;
+}
+
+// 命中且未过期时返回 true，exists 表示该用户是否存在，存在时 password 为保存的密码记录
+bool UserCache::Get(const string& name, string* password, bool* exists) {
+    assert(password && exists);
+    Shard& shard = ShardOf_(name);
+    {
+        lock_guard<mutex> locker(shard.mtx);
+        auto it = shard.items.find(name);
+        if(it != shard.items.end()) {
+            if(it->second.expireUs > MetricsNowUs()) {
+                shard.lru.splice(shard.lru.begin(), shard.lru, it->second.lru);
+                *exists = it->second.exists;
+                if(*exists) { *password = it->second.password; }
+                hits_->Inc();
+                return true;
+            }
+            shard.lru.erase(it->second.lru); // 已过期
+            shard.items.erase(it);
+        }
+    }
+    misses_->Inc();
+    return false;
+}
+
+// 写入一个存在的用户，查询到用户或注册成功后调用
+void UserCache::Put(const string& name, const string& password) {
+    Shard& shard = ShardOf_(name);
+    lock_guard<mutex> locker(shard.mtx);
+    Insert_(shard, name, password, true, ttlUs_);
+}
+
+// 记录一个不存在的用户。已有未过期的存在记录时不覆盖，
+// 避免查询线程较晚写入的“不存在”盖掉另一个线程刚注册成功写入的记录
+void UserCache::PutMissing(const string& name) {
+    if(negativeTtlUs_ == 0) { return; }
+    Shard& shard = ShardOf_(name);
+    lock_guard<mutex> locker(shard.mtx);
+    auto it = shard.items.find(name);
+    if(it != shard.items.end() && it->second.exists && it->second.expireUs > MetricsNowUs()) { return; }
+    Insert_(shard, name, "", false, negativeTtlUs_);
+}
+
+void UserCache::Erase(const string& name) {
+    Shard& shard = ShardOf_(name);
+    lock_guard<mutex> locker(shard.mtx);
+    auto it = shard.items.find(name);
+    if(it == shard.items.end()) { return; }
+    shard.lru.erase(it->second.lru);
+    shard.items.erase(it);
+}
+
+size_t UserCache::Size() {
+    size_t n = 0;
+    for(auto& shard : shards_) {
+        lock_guard<mutex> locker(shard.mtx);
+        n += shard.items.size();
+    }
+    return n;
+}
+
+// 插入或更新一条记录并移到 LRU 头部，分片满时淘汰最久未使用的记录，调用方持有分片锁
+void UserCache::Insert_(Shard& shard, const string& name, const string& password, bool exists, int64_t ttlUs) {
+    auto it = shard.items.find(name);
+    if(it != shard.items.end()) {
+        shard.lru.splice(shard.lru.begin(), shard.lru, it->second.lru);
+    } else {
+        if(shard.items.size() >= shardCapacity_) {
+            shard.items.erase(shard.lru.back());
+            shard.lru.pop_back();
+        }
+        shard.lru.push_front(name);
+        it = shard.items.emplace(name, Entry()).first;
+        it->second.lru = shard.lru.begin();
+    }
+    it->second.password = password;
+    it->second.exists = exists;
+    it->second.expireUs = MetricsNowUs() + ttlUs;
+}
@@ -0,0 +1,64 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#ifndef USERCACHE_H
+#define USERCACHE_H
+
+#include <mutex>
+#include <string>
+#include <list>
+#include <unordered_map>
+#include <functional>
+#include <assert.h>
+#include "../metrics/metrics.h"
+
+// 用户凭据缓存：用户名 -> 数据库中保存的密码记录。
+// 按用户名哈希分片，每个分片一把锁、按 LRU 淘汰，总条目数有上限；
+// 查询数据库后填充，注册成功后直接写入（write-through）；不存在的用户也缓存一段较短的时间
+class UserCache {
+public:
+    static const int SHARDS = 16;
+
+    UserCache(size_t capacity, int ttlMs, int negativeTtlMs);
+
+    static UserCache* Instance();
+
+    bool Get(const std::string& name, std::string* password, bool* exists);
+
+    void Put(const std::string& name, const std::string& password);
+
+    void PutMissing(const std::string& name);
+
+    void Erase(const std::string& name);
+
+    size_t Size();
+
+private:
+    struct Entry {
+        std::string password;
+        bool exists;      // false 表示数据库中没有该用户
+        int64_t expireUs; // 过期时间（单调时钟，微秒）
+        std::list<std::string>::iterator lru;
+    };
+
+    struct Shard {
+        std::mutex mtx;
+        std::unordered_map<std::string, Entry> items;
+        std::list<std::string> lru; // 头部最近使用
+    };
+
+    Shard& ShardOf_(const std::string& name) { return shards_[std::hash<std::string>()(name) % SHARDS]; }
+
+    void Insert_(Shard& shard, const std::string& name, const std::string& password, bool exists, int64_t ttlUs);
+
+    size_t shardCapacity_;
+    int64_t ttlUs_;
+    int64_t negativeTtlUs_;
+    Shard shards_[SHARDS];
+    Counter* hits_;
+    Counter* misses_;
+};
+
+#endif //USERCACHE_H
@@ -0,0 +1,50 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#include "arena.h"
+
+// 第一块内存在首次分配时才申请，没有请求的连接对象不占用内存
+Arena::Arena(size_t blockSize) : blockSize_(blockSize), cur_(nullptr), end_(nullptr), used_(0) {
+    assert(blockSize_ >= ALIGN);
+}
+
+Arena::~Arena() {
+    for(char* block : blocks_) { delete[] block; }
+}
+
+// 分配 n 字节（按 8 字节对齐）。当前块不够时：大块（超过块大小的 1/4）单独申请，不浪费当前块的剩余空间；
+// 否则申请一个新块作为当前块
+char* Arena::Alloc(size_t n) {
+    n = (n + ALIGN - 1) & ~(ALIGN - 1);
+    used_ += n;
+    if(blocks_.empty()) { // 第一块总是普通大小，Reset() 后作为当前块
+        cur_ = NewBlock_(blockSize_);
+        end_ = cur_ + blockSize_;
+    }
+    if(static_cast<size_t>(end_ - cur_) < n) {
+        if(n > blockSize_ / 4) { return NewBlock_(n); }
+        cur_ = NewBlock_(blockSize_);
+        end_ = cur_ + blockSize_;
+    }
+    char* p = cur_;
+    cur_ += n;
+    return p;
+}
+
+// 回收本轮分配的全部内存，保留第一块
+void Arena::Reset() {
+    used_ = 0;
+    if(blocks_.empty()) { return; }
+    for(size_t i = 1; i < blocks_.size(); i++) { delete[] blocks_[i]; }
+    blocks_.resize(1);
+    cur_ = blocks_[0];
+    end_ = cur_ + blockSize_;
+}
+
+char* Arena::NewBlock_(size_t n) {
+    char* block = new char[n];
+    blocks_.push_back(block);
+    return block;
+}
@@ -0,0 +1,71 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <vector>
+#include <stdlib.h>   // malloc, free
+#include <stddef.h>
+#include <assert.h>
+
+// 顺序分配的内存池：只分配不单独释放，Reset() 一次回收全部。
+// 每个连接的请求对象持有一个，在开始处理新请求时 Reset()，请求期间的临时数据都分配在其中。
+// Reset() 保留第一块内存，一般的请求不再向堆申请内存；超出第一块的部分按需追加新块，在下次 Reset() 时释放
+class Arena {
+public:
+    explicit Arena(size_t blockSize = BLOCK_SIZE);
+
+    ~Arena();
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    char* Alloc(size_t n);
+
+    void Reset();
+
+    size_t Used() const { return used_; }
+
+    size_t BlockCount() const { return blocks_.size(); }
+
+private:
+    static const size_t BLOCK_SIZE = 4096;
+    static const size_t ALIGN = 8;
+
+    char* NewBlock_(size_t n);
+
+    size_t blockSize_;
+    std::vector<char*> blocks_; // 已申请的内存块，第一块在 Reset() 时保留
+    char* cur_; // 当前块中的下一个可用位置
+    char* end_; // 当前块的末尾
+    size_t used_; // 本轮已分配的字节数
+};
+
+// 从 Arena 分配内存的 STL 分配器，deallocate 什么也不做，内存在 Arena::Reset() 时一起回收；
+// 只能用于在 Reset() 之前已经销毁的对象（例如本轮响应中文件映射的 shared_ptr 控制块）
+template<class T>
+struct ArenaAllocator {
+    typedef T value_type;
+
+    Arena* arena;
+
+    explicit ArenaAllocator(Arena* a) : arena(a) {}
+
+    template<class U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {}
+
+    T* allocate(size_t n) { return reinterpret_cast<T*>(arena->Alloc(n * sizeof(T))); }
+
+    void deallocate(T*, size_t) {}
+
+    template<class U>
+    bool operator==(const ArenaAllocator<U>& other) const { return arena == other.arena; }
+
+    template<class U>
+    bool operator!=(const ArenaAllocator<U>& other) const { return arena != other.arena; }
+};
+
+#endif //ARENA_H
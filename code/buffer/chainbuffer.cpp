@@ -0,0 +1,130 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#include "chainbuffer.h"
+
+// 构造函数，内存块在第一次追加时才分配
+ChainBuffer::ChainBuffer(size_t chunkSize) : chunkSize_(chunkSize), readable_(0), tailCap_(0), tailUsed_(0), head_(0) {
+    assert(chunkSize > 0);
+}
+
+// 所有数据段的可读字节数
+size_t ChainBuffer::ReadableBytes() const {
+    return readable_;
+}
+
+// 当前数据段的数量，即一次 writev 需要的 iovec 数
+size_t ChainBuffer::SegmentCount() const {
+    return segs_.size() - head_;
+}
+
+void ChainBuffer::Append(const std::string& str) {
+    Append(str.data(), str.length());
+}
+
+// 追加以 '\0' 结尾的字符串，字符串常量不必先构造 std::string
+void ChainBuffer::Append(const char* str) {
+    Append(str, strlen(str));
+}
+
+// 拷贝追加：写入当前内存块的剩余空间，紧接上一段时直接扩展上一段
+void ChainBuffer::Append(const char* str, size_t len) {
+    assert(str || len == 0);
+    if(len == 0) { return; }
+    char* dst = MakeSpace_(len);
+    std::copy(str, str + len, dst);
+    tailUsed_ += len;
+    readable_ += len;
+    if(segs_.size() > head_ && segs_.back().owner.get() == tail_.get()
+            && segs_.back().data + segs_.back().len == dst) {
+        segs_.back().len += len;
+    } else {
+        segs_.push_back({tail_, dst, len});
+    }
+}
+
+// 追加一个连续缓冲区中的全部可读数据
+void ChainBuffer::Append(const Buffer& buff) {
+    Append(buff.Peek(), buff.ReadableBytes());
+}
+
+// 零拷贝追加一段外部内存（例如文件映射），只增加引用计数
+void ChainBuffer::AppendRef(const std::shared_ptr<const char>& owner, const char* data, size_t len) {
+    assert(owner && data);
+    if(len == 0) { return; }
+    segs_.push_back({owner, data, len});
+    readable_ += len;
+}
+
+// 从头部消耗 len 字节，已经消耗完的段释放其内存块引用
+void ChainBuffer::Retrieve(size_t len) {
+    assert(len <= readable_);
+    readable_ -= len;
+    while(len > 0) {
+        Segment& seg = segs_[head_];
+        if(len < seg.len) {
+            seg.data += len;
+            seg.len -= len;
+            break;
+        }
+        len -= seg.len;
+        seg.owner.reset(); // 立即释放内存块或文件映射的引用
+        head_++;
+    }
+    if(head_ == segs_.size()) { // 全部发送完，从头复用，不释放容量
+        segs_.clear();
+        head_ = 0;
+    } else if(head_ >= COMPACT_SEGS && head_ * 2 >= segs_.size()) { // 持续追加时去掉已发送的段，避免无限增长
+        segs_.erase(segs_.begin(), segs_.begin() + head_);
+        head_ = 0;
+    }
+    if(head_ == segs_.size() && tail_.use_count() == 1) {
+        tailUsed_ = 0; // 没有数据段再引用当前内存块，下次追加从头复用
+    }
+}
+
+// 清空所有数据段
+void ChainBuffer::RetrieveAll() {
+    segs_.clear();
+    head_ = 0;
+    readable_ = 0;
+    if(tail_.use_count() == 1) {
+        tailUsed_ = 0;
+    }
+}
+
+// 将所有数据段聚集写入 fd，单次最多提交 IOV_MAX 段
+ssize_t ChainBuffer::WriteFd(int fd, int* saveErrno) {
+    struct iovec iov[MAX_IOV];
+    int cnt = 0;
+    for(auto it = segs_.begin() + head_; it != segs_.end() && cnt < MAX_IOV; ++it, ++cnt) {
+        iov[cnt].iov_base = const_cast<char*>(it->data);
+        iov[cnt].iov_len = it->len;
+    }
+    if(cnt == 0) { return 0; }
+    ssize_t len = writev(fd, iov, cnt);
+    if(len < 0) {
+        *saveErrno = errno;
+        return len;
+    }
+    Retrieve(len);
+    return len;
+}
+
+// 返回至少有 len 字节连续可写空间的位置，不够时分配新的内存块而不是搬移旧数据
+char* ChainBuffer::MakeSpace_(size_t len) {
+    if(tail_ && tailCap_ - tailUsed_ >= len) {
+        return tail_.get() + tailUsed_;
+    }
+    if(tail_ && tail_.use_count() == 1 && tailCap_ >= len) {
+        tailUsed_ = 0; // 旧内存块已无数据段引用，整块复用
+        return tail_.get();
+    }
+    size_t cap = std::max(chunkSize_, len);
+    tail_.reset(new char[cap], std::default_delete<char[]>());
+    tailCap_ = cap;
+    tailUsed_ = 0;
+    return tail_.get();
+}
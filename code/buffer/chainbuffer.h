@@ -0,0 +1,65 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+
+#ifndef CHAIN_BUFFER_H
+#define CHAIN_BUFFER_H
+#include <cstring>
+#include <string>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <limits.h>  // IOV_MAX
+#include <unistd.h>  // write
+#include <sys/uio.h> // writev
+#include <assert.h>
+#include "buffer.h"
+
+// 分段缓冲区：由引用计数的内存块串联而成，响应头、文件映射片段、动态生成的内容可以并列存放，
+// 发送时一次 writev 聚集写出，追加大块数据时不需要 memmove 或 realloc
+class ChainBuffer {
+public:
+    explicit ChainBuffer(size_t chunkSize = 4096);
+    ~ChainBuffer() = default;
+
+    size_t ReadableBytes() const;
+    size_t SegmentCount() const;
+
+    void Append(const std::string& str);
+    void Append(const char* str);
+    void Append(const char* str, size_t len);
+    void Append(const Buffer& buff);
+    // 零拷贝追加：只记录 [data, data + len)，owner 保证这段内存在发送完之前有效
+    void AppendRef(const std::shared_ptr<const char>& owner, const char* data, size_t len);
+
+    void Retrieve(size_t len);
+    void RetrieveAll();
+
+    ssize_t WriteFd(int fd, int* saveErrno);
+
+private:
+    struct Segment {
+        std::shared_ptr<const char> owner; // 持有该段所在内存块的引用
+        const char* data; // 该段可读数据的起始地址
+        size_t len; // 该段可读数据的长度
+    };
+
+    char* MakeSpace_(size_t len);
+
+    static const int MAX_IOV = IOV_MAX; // 单次 writev 能提交的最大段数
+    static const size_t COMPACT_SEGS = 64; // 已发送的段达到该数量且过半时整理
+
+    size_t chunkSize_; // 新分配内存块的默认大小
+    size_t readable_; // 所有段的可读字节总数
+
+    std::shared_ptr<char> tail_; // 当前用于拷贝追加的内存块
+    size_t tailCap_; // 当前内存块的容量
+    size_t tailUsed_; // 当前内存块已使用的字节数
+
+    std::vector<Segment> segs_; // 按发送顺序排列的数据段，[head_, size) 为未发送的部分；容量在发送完后保留复用
+    size_t head_; // 第一个未发送的段
+};
+
+#endif //CHAIN_BUFFER_H
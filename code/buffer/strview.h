@@ -0,0 +1,35 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#ifndef STRVIEW_H
+#define STRVIEW_H
+
+#include <string>
+#include <string.h>   // memcmp, strlen
+#include <stddef.h>
+
+// 只读的字符串片段，不拥有内存（C++14 没有 std::string_view）。
+// 指向请求缓冲区或请求内存池中的数据，只在所指内存有效期间使用
+struct StrView {
+    const char* data;
+    size_t len;
+
+    StrView() : data(""), len(0) {}
+    StrView(const char* d, size_t n) : data(d), len(n) {}
+    StrView(const char* s) : data(s), len(strlen(s)) {}
+    StrView(const std::string& s) : data(s.data()), len(s.size()) {}
+
+    bool empty() const { return len == 0; }
+    size_t size() const { return len; }
+
+    bool operator==(StrView other) const {
+        return len == other.len && memcmp(data, other.data, len) == 0;
+    }
+    bool operator!=(StrView other) const { return !(*this == other); }
+
+    std::string ToString() const { return std::string(data, len); }
+};
+
+#endif //STRVIEW_H
@@ -0,0 +1,74 @@
+/*
+ * @Author       : mark
+ * @Date         : 2020-06-28
+ * @copyleft Apache 2.0
+ */
+#include "config.h"
+
+using namespace std;
+
+// 去掉首尾空白
+string Config::Trim_(const string& s) {
+    size_t begin = s.find_first_not_of(" \t\r\n");
+    if(begin == string::npos) { return ""; }
+    size_t end = s.find_last_not_of(" \t\r\n");
+    return s.substr(begin, end - begin + 1);
+}
+
+// 读取配置文件，成功时替换全部内容；文件无法打开或有语法错误时返回 false，原有内容不变
+bool Config::Load(const string& path, string* err) {
+    ifstream in(path);
+    if(!in) {
+        if(err) { *err = "cannot open " + path; }
+        return false;
+    }
+    unordered_map<string, string> items;
+    string line;
+    int lineNo = 0;
+    while(getline(in, line)) {
+        lineNo++;
+        size_t hash = line.find('#');
+        if(hash != string::npos) { line.erase(hash); }
+        line = Trim_(line);
+        if(line.empty()) { continue; }
+        size_t eq = line.find('=');
+        string key = eq == string::npos ? "" : Trim_(line.substr(0, eq));
+        if(key.empty()) {
+            if(err) { *err = path + ":" + to_string(lineNo) + ": expected key = value"; }
+            return false;
+        }
+        items[key] = Trim_(line.substr(eq + 1));
+    }
+    items_.swap(items);
+    return true;
+}
+
+// 读取整数：缺省时保留 value 原值并返回 true，不是合法整数时返回 false
+bool Config::ReadInt(const string& key, int* value) const {
+    auto it = items_.find(key);
+    if(it == items_.end()) { return true; }
+    const char* s = it->second.c_str();
+    char* end = nullptr;
+    errno = 0;
+    long v = strtol(s, &end, 10);
+    if(end == s || *end != '\0' || errno == ERANGE || v < INT32_MIN || v > INT32_MAX) { return false; }
+    *value = static_cast<int>(v);
+    return true;
+}
+
+// 读取布尔值，接受 true/false、on/off、1/0
+bool Config::ReadBool(const string& key, bool* value) const {
+    auto it = items_.find(key);
+    if(it == items_.end()) { return true; }
+    const string& s = it->second;
+    if(s == "true" || s == "on" || s == "1") { *value = true; return true; }
+    if(s == "false" || s == "off" || s == "0") { *value = false; return true; }
+    return false;
+}
+
+// 读取字符串
+bool Config::ReadString(const string& key, string* value) const {
+    auto it = items_.find(key);
+    if(it != items_.end()) { *value = it->second; }
+    return true;
+}
@@ -2,4 +2,37 @@
  * @Author       : mark
  * @Date         : 2020-06-28
  * @copyleft Apache 2.0
- */ 
+ */
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include <string>
+#include <unordered_map>
+#include <fstream>
+#include <errno.h>
+#include <stdlib.h>      // strtol
+#include <stdint.h>      // INT32_MAX
+
+// 服务器配置：每行一个 key = value，# 开始的部分为注释。
+// Load() 只检查语法，取值的类型在读取时检查，便于整份配置校验通过后再一起生效
+class Config {
+public:
+    bool Load(const std::string& path, std::string* err);
+
+    bool Has(const std::string& key) const { return items_.count(key) == 1; }
+
+    bool ReadInt(const std::string& key, int* value) const;
+
+    bool ReadBool(const std::string& key, bool* value) const;
+
+    bool ReadString(const std::string& key, std::string* value) const;
+
+    const std::unordered_map<std::string, std::string>& Items() const { return items_; }
+
+private:
+    static std::string Trim_(const std::string& s);
+
+    std::unordered_map<std::string, std::string> items_;
+};
+
+#endif //CONFIG_H
@@ -0,0 +1,81 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#include "formdata.h"
+
+const int FormData::MAX_FIELDS;
+
+// 解析表单，结果追加在已有字段之后；视图指向 data 与 arena，两者需要在使用字段期间保持有效。
+// 没有 = 的片段作为值为空的字段，空片段（如 a=1&&b=2 中间）跳过
+void FormData::Parse(const char* data, size_t len, Arena& arena) {
+    size_t start = 0;   // 当前片段的起点
+    size_t eq = len;    // 当前片段中第一个 = 的位置，len 表示还没有遇到
+    bool keyEscaped = false, valueEscaped = false;
+    for(size_t i = 0; i <= len; i++) {
+        char ch = i < len ? data[i] : '&';
+        if(ch == '&') {
+            if(i > start) {
+                if(count_ == MAX_FIELDS) {
+                    LOG_WARN("Form has more than %d fields, the rest are ignored", MAX_FIELDS);
+                    return;
+                }
+                size_t keyEnd = eq < i ? eq : i;
+                Field& f = fields_[count_++];
+                f.key = Piece_(data + start, keyEnd - start, keyEscaped, arena);
+                f.value = eq < i ? Piece_(data + eq + 1, i - eq - 1, valueEscaped, arena) : StrView();
+            }
+            start = i + 1;
+            eq = len;
+            keyEscaped = valueEscaped = false;
+        } else if(ch == '=' && eq == len) {
+            eq = i;
+        } else if(ch == '+' || ch == '%') {
+            (eq == len ? keyEscaped : valueEscaped) = true;
+        }
+    }
+}
+
+// 查找字段，同名字段以最后一个为准
+bool FormData::Find(StrView key, StrView* value) const {
+    for(int i = count_ - 1; i >= 0; i--) {
+        if(fields_[i].key == key) {
+            *value = fields_[i].value;
+            return true;
+        }
+    }
+    return false;
+}
+
+// 把 len 字节解码到 dst（至少 len 字节），返回解码后的长度：+ 为空格，%XX 为对应字节；
+// % 后面不是两个十六进制数字时原样保留
+size_t FormData::Decode(const char* src, size_t len, char* dst) {
+    size_t n = 0;
+    for(size_t i = 0; i < len; i++) {
+        char ch = src[i];
+        if(ch == '+') {
+            dst[n++] = ' ';
+        } else if(ch == '%' && i + 2 < len && HexVal_(src[i + 1]) >= 0 && HexVal_(src[i + 2]) >= 0) {
+            dst[n++] = static_cast<char>(HexVal_(src[i + 1]) * 16 + HexVal_(src[i + 2]));
+            i += 2;
+        } else {
+            dst[n++] = ch;
+        }
+    }
+    return n;
+}
+
+// 不需要解码的片段直接引用原数据，否则解码到内存池中
+StrView FormData::Piece_(const char* data, size_t len, bool escaped, Arena& arena) {
+    if(!escaped) { return StrView(data, len); }
+    char* dst = arena.Alloc(len);
+    return StrView(dst, Decode(data, len, dst));
+}
+
+int FormData::HexVal_(char ch) {
+    if(ch >= '0' && ch <= '9') return ch - '0';
+    if(ch >= 'A' && ch <= 'F') return ch - 'A' + 10;
+    if(ch >= 'a' && ch <= 'f') return ch - 'a' + 10;
+    return -1;
+}
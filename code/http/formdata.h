@@ -0,0 +1,46 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#ifndef FORM_DATA_H
+#define FORM_DATA_H
+
+#include "../buffer/strview.h"
+#include "../buffer/arena.h"
+#include "../log/log.h"
+
+// application/x-www-form-urlencoded 表单：一次扫描切分 key=value&...，键与值都是视图。
+// 不含 + 与 %XX 的片段直接指向请求体，需要解码的才解码到请求的内存池中，不修改请求体。
+// 登录注册只有两三个字段，用定长数组顺序查找，比哈希表更快且不申请内存
+class FormData {
+public:
+    static const int MAX_FIELDS = 16; // 超出的字段忽略
+
+    FormData() : count_(0) {}
+
+    void Clear() { count_ = 0; }
+
+    void Parse(const char* data, size_t len, Arena& arena);
+
+    bool Find(StrView key, StrView* value) const;
+
+    int Size() const { return count_; }
+
+    static size_t Decode(const char* src, size_t len, char* dst);
+
+private:
+    struct Field {
+        StrView key;
+        StrView value;
+    };
+
+    static StrView Piece_(const char* data, size_t len, bool escaped, Arena& arena);
+
+    static int HexVal_(char ch);
+
+    Field fields_[MAX_FIELDS];
+    int count_;
+};
+
+#endif //FORM_DATA_H
@@ -9,12 +9,57 @@ using namespace std;
 const char* HttpConn::srcDir; // HTTP服务器的根目录
 std::atomic<int> HttpConn::userCount; // 连接的用户数量。
 bool HttpConn::isET; // 是否采用边缘触发模式
+std::atomic<uint32_t> HttpConn::connGen_; // 连接代数计数器
+const char* HttpConn::METRICS_PATH = "/metrics";
+SessionStore* HttpConn::sessions = nullptr;
+
+namespace {
+// 连接上的请求与流量指标，首次使用时登记
+struct ConnMetrics {
+    Counter* requests[5]; // 按状态码 200、400、403、404、其他
+    Counter* bytesRead;
+    Counter* bytesWritten;
+
+    ConnMetrics() {
+        MetricsRegistry* reg = MetricsRegistry::Instance();
+        const char* codes[] = { "200", "400", "403", "404", "other" };
+        for(int i = 0; i < 5; i++) {
+            requests[i] = reg->GetCounter("webserver_requests_total", "HTTP responses by status code.",
+                                          std::string("code=\"") + codes[i] + "\"");
+        }
+        bytesRead = reg->GetCounter("webserver_bytes_read_total", "Bytes read from client sockets.");
+        bytesWritten = reg->GetCounter("webserver_bytes_written_total", "Bytes written to client sockets.");
+    }
+
+    Counter* Requests(int code) {
+        switch(code) {
+        case 200: return requests[0];
+        case 400: return requests[1];
+        case 403: return requests[2];
+        case 404: return requests[3];
+        default: return requests[4];
+        }
+    }
+};
+
+ConnMetrics& Metrics() {
+    static ConnMetrics metrics;
+    return metrics;
+}
+}
 
 // 默认构造函数
 HttpConn::HttpConn() { 
     fd_ = -1; // 当前网络连接的文件描述符尚未被指定或无效。
     addr_ = { 0 };
+    ip_[0] = '\0';
     isClose_ = true;
+    connId_ = 0;
+    lastActive_ = 0;
+    reqStartUs_ = reqWallUs_ = 0;
+    reqSeq_ = 0;
+    stage_ = IDLE;
+    respBytes_ = 0;
 };
 
 // 析构函数
@@ -27,18 +72,24 @@ void HttpConn::init(int fd, const sockaddr_in& addr) {
     assert(fd > 0); // 使用断言确保传入的文件描述符 fd 大于 0
     userCount++; // 增加连接用户计数器
     addr_ = addr; // 将传入的远程地址信息 addr 复制给成员变量 addr_
+    inet_ntop(AF_INET, &addr_.sin_addr, ip_, sizeof(ip_)); // 可重入，不使用 inet_ntoa 的静态缓冲区
     fd_ = fd; // 将传入的文件描述符 fd 赋值给成员变量 fd_
+    connId_.store((static_cast<uint64_t>(++connGen_) << 32) | static_cast<uint32_t>(fd),
+                  std::memory_order_release); // 新的代数，旧连接遗留的定时器与取消请求不会误伤本连接
     writeBuff_.RetrieveAll(); // 清空写缓冲区
     readBuff_.RetrieveAll(); // 清空读缓冲区
     isClose_ = false; // 连接状态
+    reqSeq_ = 0;
+    stage_ = IDLE;
+    trace_.Reset();
     LOG_INFO("Client[%d](%s:%d) in, userCount:%d", fd_, GetIP(), GetPort(), (int)userCount); // 记录连接建立的日志信息
 }
 
 // 关闭当前的 HTTP 连接
 void HttpConn::Close() {
-    response_.UnmapFile(); // 取消映射的文件
-    if(isClose_ == false){ // 检查当前连接是否已关闭
-        isClose_ = true; 
+    if(isClose_.exchange(true) == false){ // 检查并标记当前连接已关闭，保证并发关闭时只执行一次
+        writeBuff_.RetrieveAll(); // 丢弃未发送的数据段，释放其持有的文件映射
+        response_.UnmapFile(); // 取消映射的文件
         userCount--; // 用户计数减一
         close(fd_); // 关闭套接字文件描述符 fd_。
         LOG_INFO("Client[%d](%s:%d) quit, UserCount:%d", fd_, GetIP(), GetPort(), (int)userCount);// 记录连接关闭的日志信息
@@ -57,7 +108,7 @@ struct sockaddr_in HttpConn::GetAddr() const {
 
 //获取当前连接的客户端 IP 地址
 const char* HttpConn::GetIP() const {
-    return inet_ntoa(addr_.sin_addr);
+    return ip_;
 }
 
 // 获取端口
@@ -68,67 +119,152 @@ int HttpConn::GetPort() const {
 // 客户端读取数据，存放在读缓冲区中
 ssize_t HttpConn::read(int* saveErrno) {
     ssize_t len = -1;
+    size_t total = 0;
     do {
         len = readBuff_.ReadFd(fd_, saveErrno);//从fd_中读取数据到读缓冲区中。返回读取的字节数。
         if (len <= 0) {
             break;
         }
+        total += len;
     } while (isET); // 是否使用了边缘触发模式。
+    if(total > 0) { Metrics().bytesRead->Inc(total); } // 每次读事件只计一次数
     return len;
 }
 
 // 将写缓冲区中的数据写入到套接字文件描述符中
 ssize_t HttpConn::write(int* saveErrno) {
     ssize_t len = -1;
+    size_t total = 0;
     do {
-        len = writev(fd_, iov_, iovCnt_); // 调用writev函数将分散的数据一并写入到套接字文件描述符中，并返回写入的字节数。
+        len = writeBuff_.WriteFd(fd_, saveErrno); // 将所有数据段通过一次 writev 聚集写入套接字，并返回写入的字节数。
         if(len <= 0) { //写入的字节数小于等于 0
             *saveErrno = errno; // 将错误码保存到指定的变量中
             break;
         }
-        if(iov_[0].iov_len + iov_[1].iov_len  == 0) { break; } //待发送的数据量为 0，表示传输结束，跳出循环。
-        else if(static_cast<size_t>(len) > iov_[0].iov_len) { // 写入的字节数大于第一个缓冲区中的数据量
-            iov_[1].iov_base = (uint8_t*) iov_[1].iov_base + (len - iov_[0].iov_len);// 更新 iov_ 数组中的数据信息，并将写缓冲区中已发送的数据部分删除。
-            iov_[1].iov_len -= (len - iov_[0].iov_len);
-            if(iov_[0].iov_len) {
-                writeBuff_.RetrieveAll();
-                iov_[0].iov_len = 0;
-            }
-        }
-        else {
-            iov_[0].iov_base = (uint8_t*)iov_[0].iov_base + len; // 更新 iov_ 数组中的数据信息，并将写缓冲区中已发送的数据删除。
-            iov_[0].iov_len -= len; 
-            writeBuff_.Retrieve(len);
+        total += len;
+        if(trace_.firstByte == 0) { trace_.firstByte = MetricsNowUs(); }
+        if(ToWriteBytes() == 0) { //待发送的数据量为 0，表示传输结束，跳出循环。
+            trace_.lastByte = MetricsNowUs();
+            break;
         }
     } while(isET || ToWriteBytes() > 10240); // 直到发送完所有数据或者写缓冲区中的数据量超过一定阈值（10KB）为止
+    if(total > 0) { Metrics().bytesWritten->Inc(total); }
     return len;
 }
 
 // 处理HTTP请求
 bool HttpConn::process() {
-    request_.Init(); // 初始化HTTP请求对象。
+    response_.UnmapFile(); // 上一个响应已经发送完，先释放文件映射，其控制块在请求的内存池中
+    request_.Init(); // 初始化HTTP请求对象，回收上一个请求的内存池。
     if(readBuff_.ReadableBytes() <= 0) { // 读缓冲区无效
+        stage_.store(IDLE, std::memory_order_relaxed);
         return false;
     }
-    else if(request_.parse(readBuff_)) { // 解析HTTP请求
-        LOG_DEBUG("%s", request_.path().c_str()); // 记录日志，解析成功
-        response_.Init(srcDir, request_.path(), request_.IsKeepAlive(), 200); // 初始化HTTP响应对象
+    reqSeq_.store(reqSeq_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed); // 只有处理该连接的线程写入，无需原子加
+    stage_.store(PROCESSING, std::memory_order_relaxed);
+    reqStartUs_ = MetricsNowUs();
+    if(trace_.dequeue == 0) { // 长连接上写完响应后直接处理缓冲区中的下一个请求，没有经过线程池
+        trace_.enqueue = trace_.dequeue = reqStartUs_;
+    }
+    trace_.parseStart = reqStartUs_;
+    if(AccessLog::Instance()->IsOpen()) { // 只有打开访问日志时才读取墙上时钟
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        reqWallUs_ = static_cast<int64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+    }
+    bool parsed = request_.parse(readBuff_); // 解析HTTP请求
+    trace_.parseDone = MetricsNowUs();
+    if(parsed && request_.IsAuthPending()) { // 登录注册交给数据库执行器，不在工作线程中等待数据库
+        stage_.store(WAITING_DB, std::memory_order_relaxed);
+        return true;
+    }
+    if(parsed) { CheckSession_(); }
+    MakeResponse_(parsed);
+    return true;
+}
+
+// 请求带有效的会话 cookie 时记录用户名，只查内存中的会话表；已登录的用户打开登录页时直接进入欢迎页
+void HttpConn::CheckSession_() {
+    if(!sessions) { return; }
+    StrView token = request_.GetCookie(SessionStore::COOKIE_NAME);
+    std::string user;
+    if(token.empty() || !sessions->Check(token, &user)) { return; }
+    request_.SetUser(user);
+    if(request_.method() == "GET" && request_.path() == "/login.html") {
+        request_.SetPath("/welcome.html");
+    }
+}
+
+// 生成响应：头部写入写缓冲区，文件内容以引用段的形式追加；cookie 不为空时随响应下发 Set-Cookie
+void HttpConn::MakeResponse_(bool parsed, const std::string& cookie) {
+    if(parsed) {
+        LOG_DEBUG("%s", request_.path().data); // 记录日志，解析成功
+        response_.Init(srcDir, request_.path(), request_.GetArena(), request_.IsKeepAlive(), 200); // 初始化HTTP响应对象，与请求共用内存池
     } else {
-        response_.Init(srcDir, request_.path(), false, 400);
+        response_.Init(srcDir, request_.path(), request_.GetArena(), false, 400);
     }
+    if(!cookie.empty()) { response_.SetCookie(cookie); }
 
-    response_.MakeResponse(writeBuff_); // 根据响应对象生成相应的响应内容，存储到写缓冲区中。
-    /* 响应头 */
-    iov_[0].iov_base = const_cast<char*>(writeBuff_.Peek()); // 设置 iov_ 结构体数组，用于在 write 方法中进行写操作。
-    iov_[0].iov_len = writeBuff_.ReadableBytes();
-    iovCnt_ = 1;
-
-    /* 文件 */
-    if(response_.FileLen() > 0  && response_.File()) {
-        iov_[1].iov_base = response_.File();
-        iov_[1].iov_len = response_.FileLen();
-        iovCnt_ = 2;
+    if(parsed && request_.path() == METRICS_PATH) { // 保留路径：输出当前的全部指标
+        response_.MakeBodyResponse(writeBuff_, MetricsRegistry::Instance()->Render(),
+                                   "text/plain; version=0.0.4");
+    } else {
+        response_.MakeResponse(writeBuff_); // 根据响应对象生成响应头，文件内容以引用段的形式追加到写缓冲区中。
     }
-    LOG_DEBUG("filesize:%d, %d  to %d", response_.FileLen() , iovCnt_, ToWriteBytes());
-    return true;
+    trace_.handlerDone = MetricsNowUs();
+    stage_.store(WRITING, std::memory_order_relaxed);
+    Metrics().Requests(response_.Code())->Inc();
+    respBytes_ = writeBuff_.ReadableBytes();
+    LOG_DEBUG("filesize:%d, %d  to %d", response_.FileLen() , writeBuff_.SegmentCount(), ToWriteBytes());
+}
+
+// 数据库执行器完成校验后调用（工作线程中），根据结果生成响应；成功时签发会话，之后的请求凭 cookie 识别用户
+void HttpConn::CompleteAuth(bool ok, int64_t dbStartUs, int64_t dbDoneUs) {
+    trace_.dbStart = dbStartUs;
+    trace_.dbDone = dbDoneUs;
+    request_.FinishAuth(ok);
+    std::string cookie;
+    if(ok && sessions) {
+        std::string user = request_.GetPost("username");
+        std::string token = sessions->Create(user);
+        if(!token.empty()) {
+            request_.SetUser(user);
+            cookie = std::string(SessionStore::COOKIE_NAME) + "=" + token + "; Path=/; Max-Age="
+                     + std::to_string(sessions->TtlSec()) + "; HttpOnly; SameSite=Lax";
+        }
+    }
+    MakeResponse_(true, cookie);
+}
+
+// 响应全部写出后记录一条访问日志，只拷贝定长记录，格式化与写文件由后台线程完成
+void HttpConn::LogAccess() {
+    AccessLog* log = AccessLog::Instance();
+    if(!log->IsOpen()) { return; }
+    AccessRecord rec;
+    rec.timeUs = reqWallUs_;
+    rec.latencyUs = (trace_.lastByte ? trace_.lastByte : MetricsNowUs()) - reqStartUs_;
+    rec.bytes = respBytes_;
+    rec.ip = addr_.sin_addr.s_addr;
+    rec.port = ntohs(addr_.sin_port);
+    rec.status = static_cast<uint16_t>(response_.Code());
+    rec.seq = RequestCount();
+    rec.keepAlive = IsKeepAlive();
+    StrView method = request_.method();
+    StrView path = request_.path();
+    snprintf(rec.method, sizeof(rec.method), "%.*s", static_cast<int>(method.len), method.data);
+    snprintf(rec.path, sizeof(rec.path), "%.*s", static_cast<int>(path.len), path.data);
+    log->Append(rec);
+}
+
+// 响应全部写出后把本次请求的各阶段耗时交给 RequestTracer，并清空时间点等待下一个请求
+void HttpConn::FinishTrace() {
+    RequestTracer::Instance()->Finish(trace_, fd_, request_.path().data, response_.Code());
+    trace_.Reset();
+    stage_.store(IDLE, std::memory_order_relaxed);
+}
+
+// 阶段名称
+const char* HttpConn::StageName(ConnStage stage) {
+    static const char* NAMES[] = { "idle", "queued", "processing", "waiting_db", "writing" };
+    return NAMES[stage];
 }
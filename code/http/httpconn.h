@@ -14,13 +14,28 @@
 #include <errno.h>      
 
 #include "../log/log.h"
+#include "../log/accesslog.h"
 #include "../pool/sqlconnRAII.h"
 #include "../buffer/buffer.h"
+#include "../buffer/chainbuffer.h"
+#include "../timer/timewheel.h"
+#include "../metrics/metrics.h"
+#include "../metrics/requesttrace.h"
+#include "../auth/sessionstore.h"
 #include "httprequest.h"
 #include "httpresponse.h"
 
 class HttpConn {
 public:
+    // 连接当前所处的阶段，供管理接口查看
+    enum ConnStage {
+        IDLE,       // 等待请求
+        QUEUED,     // 读事件在线程池中排队
+        PROCESSING, // 读取与处理请求
+        WAITING_DB, // 等待数据库执行器完成登录注册校验
+        WRITING,    // 写出响应
+    };
+
     HttpConn();
 
     ~HttpConn();
@@ -35,6 +50,15 @@ public:
 
     int GetFd() const;
 
+    // 带代数的连接 id：低 32 位为 fd，高 32 位为建立连接时的代数，用于区分复用同一 fd 的不同连接
+    uint64_t GetConnId() const {
+        return connId_.load(std::memory_order_acquire);
+    }
+
+    bool IsClose() const {
+        return isClose_;
+    }
+
     int GetPort() const;
 
     const char* GetIP() const;
@@ -43,34 +67,100 @@ public:
     
     bool process();
 
+    // 请求需要数据库校验，响应在 CompleteAuth() 中生成
+    bool IsAuthPending() const {
+        return request_.IsAuthPending();
+    }
+
+    void CompleteAuth(bool ok, int64_t dbStartUs, int64_t dbDoneUs);
+
+    const HttpRequest& GetRequest() const {
+        return request_;
+    }
+
+    void LogAccess();
+
+    // 主线程把读事件交给线程池时记录入队时间
+    void MarkEnqueue() {
+        trace_.enqueue = MetricsNowUs();
+        stage_.store(QUEUED, std::memory_order_relaxed);
+    }
+
+    // 工作线程开始处理读事件时记录出队时间
+    void MarkDequeue() {
+        trace_.dequeue = MetricsNowUs();
+    }
+
+    void FinishTrace();
+
+    ConnStage Stage() const {
+        return stage_.load(std::memory_order_relaxed);
+    }
+
+    static const char* StageName(ConnStage stage);
+
+    // 本连接上已处理的请求数
+    uint32_t RequestCount() const {
+        return reqSeq_.load(std::memory_order_relaxed);
+    }
+
     // 表示待写入的字节数
     int ToWriteBytes() { 
-        return iov_[0].iov_len + iov_[1].iov_len; 
+        return writeBuff_.ReadableBytes(); 
     }
 
     bool IsKeepAlive() const {
         return request_.IsKeepAlive();
     }
 
+    // 嵌入在连接中的定时器节点
+    TimerNode* GetTimer() {
+        return &timer_;
+    }
+
+    // 记录最近一次活动的粗粒度时间，只写一个时间戳，不改动定时器
+    void Touch(int64_t nowMs) {
+        lastActive_.store(nowMs, std::memory_order_relaxed);
+    }
+
+    int64_t LastActive() const {
+        return lastActive_.load(std::memory_order_relaxed);
+    }
+
     static bool isET; // 是否是ET模式
     static const char* srcDir; // HTTP服务器的根目录
     static std::atomic<int> userCount; // 连接的用户数量。
+    static const char* METRICS_PATH; // 输出指标的保留路径
+    static SessionStore* sessions; // 会话存储，为空时不签发也不校验会话
     
 private:
-   
+    void MakeResponse_(bool parsed, const std::string& cookie = std::string());
+
+    void CheckSession_();
+
     int fd_; // 网络连接的文件描述符
     struct  sockaddr_in addr_; // 地址信息
+    char ip_[INET_ADDRSTRLEN]; // 点分十进制地址，建立连接时转换一次
 
-    bool isClose_; // 当前连接是否关闭
-    
-    int iovCnt_; // I/O向量的数量
-    struct iovec iov_[2]; // 用于进行分散/聚集 I/O 操作。
+    std::atomic<bool> isClose_; // 当前连接是否关闭，主线程与工作线程都可能关闭连接
+    std::atomic<uint64_t> connId_; // 带代数的连接 id
+    static std::atomic<uint32_t> connGen_; // 连接代数计数器
     
     Buffer readBuff_; // 读缓冲区
-    Buffer writeBuff_; // 写缓冲区
+    ChainBuffer writeBuff_; // 写缓冲区，响应头与文件映射片段分段存放，聚集写出
 
     HttpRequest request_; // HTTP请求对象
     HttpResponse response_; // HTTP响应对象
+
+    TimerNode timer_; // 超时定时器节点，由时间轮直接链接，无需按 fd 查表
+    std::atomic<int64_t> lastActive_; // 最近一次读写事件的时间（毫秒），定时器到期时据此判断是否真的空闲
+
+    RequestTrace trace_; // 当前请求各阶段的时间点
+    int64_t reqStartUs_; // 当前请求开始处理的单调时钟时间（微秒），用于计算访问日志中的耗时
+    int64_t reqWallUs_; // 当前请求开始处理的墙上时间（微秒）
+    std::atomic<uint32_t> reqSeq_; // 本连接上已处理的请求数，管理接口在主线程读取
+    std::atomic<ConnStage> stage_; // 当前阶段，只做 relaxed 读写
+    size_t respBytes_; // 当前响应的总字节数
 };
 
 
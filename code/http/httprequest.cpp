@@ -7,29 +7,33 @@
 
 using namespace std;
 
-const unordered_set <string> HttpRequest::DEFAULT_HTML{
+const char* HttpRequest::DEFAULT_HTML[] = {
         "/index", "/register", "/login",
         "/welcome", "/video", "/picture",};
 
-const unordered_map<string, int> HttpRequest::DEFAULT_HTML_TAG{
-        {"/register.html", 0},
-        {"/login.html",    1},};
-
 //初始化
 void HttpRequest::Init() {
-    method_ = path_ = version_ = body_ = ""; //HTTP请求中的方法、路径、版本和请求体
+    arena_.Reset(); // 回收上一个请求的临时内存，之前返回的视图全部失效
+    method_ = path_ = version_ = body_ = StrView(); //HTTP请求中的方法、路径、版本和请求体
     state_ = REQUEST_LINE;//请求行状态
-    header_.clear();//清空
-    post_.clear();
+    headerCount_ = 0;//清空
+    post_.Clear();
+    authPending_ = false;
+    authLogin_ = false;
+    user_.clear();
+}
+
+// 数据库校验完成后根据结果确定响应页面
+void HttpRequest::FinishAuth(bool ok) {
+    assert(authPending_);
+    authPending_ = false;
+    path_ = ok ? "/welcome.html" : "/error.html";
 }
 
 // 检查HTTP请求是否是持久连接
 bool HttpRequest::IsKeepAlive() const {
-    if (header_.count("Connection") == 1) {//检查请求头中是否包含"Connection"字段
-        return header_.find("Connection")->second == "keep-alive" &&
-               version_ == "1.1";//该字段的值为"keep-alive"，并且请求的HTTP版本是"1.1"，则返回true
-    }
-    return false;
+    return GetHeader("Connection") == "keep-alive" &&
+           version_ == "1.1";//该字段的值为"keep-alive"，并且请求的HTTP版本是"1.1"，则返回true
 }
 
 // 解析HTTP请求
@@ -39,8 +43,8 @@ bool HttpRequest::parse(Buffer &buff) {
         return false;
     }
     while (buff.ReadableBytes() && state_ != FINISH) {
-        const char *lineEnd = search(buff.Peek(), buff.BeginWriteConst(), CRLF, CRLF + 2);//从缓冲区中提取一个完整的行，并将其存储为一个字符串
-        std::string line(buff.Peek(), lineEnd);//从缓冲区中提取的一行数据存储到line中
+        const char *lineEnd = search(buff.Peek(), buff.BeginWriteConst(), CRLF, CRLF + 2);//从缓冲区中找出一个完整的行
+        StrView line = Dup_(StrView(buff.Peek(), lineEnd - buff.Peek()));//读缓冲区之后会被清空复用，拷贝到内存池中
         switch (state_) {
             case REQUEST_LINE:
                 if (!ParseRequestLine_(line)) {//解析请求行
@@ -63,32 +67,47 @@ bool HttpRequest::parse(Buffer &buff) {
         if (lineEnd == buff.BeginWrite()) { break; } // lineEnd的位置等于缓冲区的写指针位置
         buff.RetrieveUntil(lineEnd + 2);// 移除已经处理过的数据
     }
-    LOG_DEBUG("[%s], [%s], [%s]", method_.c_str(), path_.c_str(), version_.c_str());//日志记录，方法、路径和版本
+    LOG_DEBUG("[%s], [%s], [%s]", method_.data, path_.data, version_.data);//日志记录，方法、路径和版本
     return true;
 }
 
+// 把 s 拷贝到内存池中并以 '\0' 结尾
+StrView HttpRequest::Dup_(StrView s) {
+    char *p = arena_.Alloc(s.len + 1);
+    memcpy(p, s.data, s.len);
+    p[s.len] = '\0';
+    return StrView(p, s.len);
+}
+
 //解析路径
 void HttpRequest::ParsePath_() {
     if (path_ == "/") {//如果路径是根路径 "/"
         path_ = "/index.html"; //将其设置为默认的首页路径 "/index.html"
     } else {
-        for (auto &item: DEFAULT_HTML) {//遍历HTML页面列表中
-            if (item == path_) {
-                path_ += ".html";//将其后缀设置为 ".html"
+        for (const char *item: DEFAULT_HTML) {//遍历HTML页面列表中
+            if (path_ == item) {
+                char *p = arena_.Alloc(path_.len + 6);
+                memcpy(p, path_.data, path_.len);
+                memcpy(p + path_.len, ".html", 6);//将其后缀设置为 ".html"
+                path_ = StrView(p, path_.len + 5);
                 break;
             }
         }
     }
 }
 
-// 解析请求行
-bool HttpRequest::ParseRequestLine_(const string &line) {
-    regex patten("^([^ ]*) ([^ ]*) HTTP/([^ ]*)$");//正则表达式用于匹配HTTP请求行
-    smatch subMatch;//用于保存正则表达式的匹配结果
-    if (regex_match(line, subMatch, patten)) {
-        method_ = subMatch[1];//方法
-        path_ = subMatch[2];//路径
-        version_ = subMatch[3];//HTTP版本
+// 解析请求行：方法 路径 HTTP/版本，三段之间各一个空格，各段中不含空格
+bool HttpRequest::ParseRequestLine_(StrView line) {
+    const char *end = line.data + line.len;
+    const char *sp1 = static_cast<const char *>(memchr(line.data, ' ', line.len));
+    const char *sp2 = sp1 ? static_cast<const char *>(memchr(sp1 + 1, ' ', end - sp1 - 1)) : nullptr;
+    if (sp2 && end - sp2 - 1 >= 5 && memcmp(sp2 + 1, "HTTP/", 5) == 0 && !memchr(sp2 + 6, ' ', end - sp2 - 6)) {
+        char *p = const_cast<char *>(line.data); // line 在内存池中，把分隔的空格改为 '\0'，各段都以 '\0' 结尾
+        p[sp1 - line.data] = '\0';
+        p[sp2 - line.data] = '\0';
+        method_ = StrView(line.data, sp1 - line.data);//方法
+        path_ = StrView(sp1 + 1, sp2 - sp1 - 1);//路径
+        version_ = StrView(sp2 + 6, end - sp2 - 6);//HTTP版本
         state_ = HEADERS;//状态设置为解析请求头部
         return true;
     }
@@ -96,183 +115,89 @@ bool HttpRequest::ParseRequestLine_(const string &line) {
     return false;
 }
 
-// 解析请求头
-void HttpRequest::ParseHeader_(const string &line) {
-    regex patten("^([^:]*): ?(.*)$");
-    smatch subMatch;
-    if (regex_match(line, subMatch, patten)) {
-        header_[subMatch[1]] = subMatch[2];// 存储键值对
-    } else {
+// 解析请求头：键: 值，冒号后最多跳过一个空格；没有冒号的行（空行）表示头部结束
+void HttpRequest::ParseHeader_(StrView line) {
+    const char *colon = static_cast<const char *>(memchr(line.data, ':', line.len));
+    if (!colon) {
         state_ = BODY;//更新状态
+        return;
+    }
+    if (headerCount_ == MAX_HEADERS) {
+        LOG_DEBUG("More than %d headers, ignored", static_cast<int>(MAX_HEADERS));
+        return;
     }
+    const char *value = colon + 1;
+    const char *end = line.data + line.len;
+    if (value < end && *value == ' ') { value++; }
+    header_[headerCount_].key = StrView(line.data, colon - line.data);// 存储键值对
+    header_[headerCount_].value = StrView(value, end - value);
+    headerCount_++;
 }
 
 // 解析HTTP请求体
-void HttpRequest::ParseBody_(const string &line) {
-    body_ = line;//请求体内容存储到 body_ 中
+void HttpRequest::ParseBody_(StrView line) {
+    body_ = line;//请求体内容已拷贝在内存池中
     ParsePost_();//解析POST请求
     state_ = FINISH;//将状态更新为 FINISH
-    LOG_DEBUG("Body:%s, len:%d", line.c_str(), line.size());//记录日志
-}
-
-int HttpRequest::ConverHex(char ch) {
-    if (ch >= 'A' && ch <= 'F') return ch - 'A' + 10;
-    if (ch >= 'a' && ch <= 'f') return ch - 'a' + 10;
-    return ch;
+    LOG_DEBUG("Body len:%d, fields:%d", static_cast<int>(line.len), post_.Size());//只记录长度与字段数，请求体中可能有密码
 }
 
 // 解析HTTP POST请求中的表单数据
 void HttpRequest::ParsePost_() {
-    if (method_ == "POST" && header_["Content-Type"] ==
+    if (method_ == "POST" && GetHeader("Content-Type") ==
                              "application/x-www-form-urlencoded") {//请求方法是POST，请求头中的Content-Type是"application/x-www-form-urlencoded"
         ParseFromUrlencoded_();//解析表单数据
-        if (DEFAULT_HTML_TAG.count(path_)) {//检查路径是否在默认HTML标签列表中
-            int tag = DEFAULT_HTML_TAG.find(path_)->second;
-            LOG_DEBUG("Tag:%d", tag);
-            if (tag == 0 || tag == 1) {
-                bool isLogin = (tag == 1);
-                if (UserVerify(post_["username"], post_["password"], isLogin)) { //0注册用户,1登录用户
-                    path_ = "/welcome.html";
-                } else {
-                    path_ = "/error.html";
-                }
-            }
+        if (path_ == "/register.html" || path_ == "/login.html") {//登录与注册页面
+            authLogin_ = (path_ == "/login.html"); //注册用户或登录用户
+            LOG_DEBUG("Tag:%d", authLogin_ ? 1 : 0);
+            authPending_ = true; // 不在工作线程中查询数据库，由调用方异步校验后调用 FinishAuth
         }
     }
 }
 
-// 解析URL编码的表单数据
+// 解析URL编码的表单数据，字段是指向 body_ 或 arena_ 的视图，不修改 body_
 void HttpRequest::ParseFromUrlencoded_() {
-    if (body_.size() == 0) { return; }//检查body_是否为空
-
-    string key, value;
-    int num = 0;
-    int n = body_.size();
-    int i = 0, j = 0;
-
-    for (; i < n; i++) {//遍历整个 body_，对每个字符进行处理
-        char ch = body_[i];
-        switch (ch) {
-            case '=':
-                key = body_.substr(j, i - j);//表示键值对的键名结束，接着开始解析值
-                j = i + 1;
-                break;
-            case '+':
-                body_[i] = ' ';//将其替换为空格；
-                break;
-            case '%'://表示接下来两个字符是十六进制数，需要将其转换成字符；
-                num = ConverHex(body_[i + 1]) * 16 + ConverHex(body_[i + 2]);
-                body_[i + 2] = num % 10 + '0';
-                body_[i + 1] = num / 10 + '0';
-                i += 2;
-                break;
-            case '&'://表示键值对的值结束，将键值对插入到 post_ 中，并输出调试信息；
-                value = body_.substr(j, i - j);
-                j = i + 1;
-                post_[key] = value;
-                LOG_DEBUG("%s = %s", key.c_str(), value.c_str());
-                break;
-            default:
-                break;
-        }
-    }
-    assert(j <= i);
-    if (post_.count(key) == 0 && j < i) {//将最后一个键值对插入到 post_ 中
-        value = body_.substr(j, i - j);
-        post_[key] = value;
-    }
+    post_.Parse(body_.data, body_.len, arena_);
 }
 
-// 用于验证用户身份或注册用户
-bool HttpRequest::UserVerify(const string &name, const string &pwd, bool isLogin) {
-    if (name == "" || pwd == "") { return false; }
-    LOG_INFO("Verify name:%s pwd:%s", name.c_str(), pwd.c_str());
-    MYSQL *sql;
-    SqlConnRAII(&sql, SqlConnPool::Instance());
-    assert(sql);
-
-    bool flag = false;//标识查询结果是否符合预期
-    unsigned int j = 0;//记录查询结果集中的字段数量
-    char order[256] = {0};//存储 SQL 查询语句的缓冲区
-    MYSQL_FIELD *fields = nullptr;//存储查询结果集中的字段信息
-    MYSQL_RES *res = nullptr;//用于存储查询结果集
-
-    if (!isLogin) { flag = true; }
-    /* 查询用户及密码 */
-    snprintf(order, 256, "SELECT username, password FROM user WHERE username='%s' LIMIT 1", name.c_str());
-    LOG_DEBUG("%s", order);
-
-    if (mysql_query(sql, order)) { //执行 SQL 查询语句
-        mysql_free_result(res);//释放 res 指向的查询结果集内存
-        return false;
-    }
-    res = mysql_store_result(sql);//释放 res 指向的查询结果集内存
-    j = mysql_num_fields(res);//获取查询结果集中的字段数量，将结果保存在 j 中
-    fields = mysql_fetch_fields(res);//获取查询结果集中的字段信息，并将结果保存在 fields 中
-
-    while (MYSQL_ROW row = mysql_fetch_row(res)) {
-        LOG_DEBUG("MYSQL ROW: %s %s", row[0], row[1]);
-        string password(row[1]);
-        /* 注册行为 且 用户名未被使用*/
-        if (isLogin) {
-            if (pwd == password) { flag = true; }
-            else {
-                flag = false;
-                LOG_DEBUG("pwd error!");
-            }
-        } else {
-            flag = false;
-            LOG_DEBUG("user used!");
-        }
-    }
-    mysql_free_result(res);
-
-    /* 注册行为 且 用户名未被使用*/
-    if (!isLogin && flag == true) {
-        LOG_DEBUG("regirster!");
-        bzero(order, 256);
-        snprintf(order, 256, "INSERT INTO user(username, password) VALUES('%s','%s')", name.c_str(), pwd.c_str());
-        LOG_DEBUG("%s", order);
-        if (mysql_query(sql, order)) {
-            LOG_DEBUG("Insert error!");
-            flag = false;
+// 获取请求头，名称不区分大小写，同名头部以最后一个为准；没有时返回空视图
+StrView HttpRequest::GetHeader(StrView key) const {
+    for (int i = headerCount_ - 1; i >= 0; i--) {
+        const StrView &k = header_[i].key;
+        if (k.len == key.len && strncasecmp(k.data, key.data, key.len) == 0) {
+            return header_[i].value;
         }
-        flag = true;
     }
-    SqlConnPool::Instance()->FreeConn(sql);
-    LOG_DEBUG("UserVerify success!!");
-    return flag;
-}
-
-std::string HttpRequest::path() const {
-    return path_;
-}
-
-std::string &HttpRequest::path() {
-    return path_;
-}
-
-std::string HttpRequest::method() const {
-    return method_;
-}
-
-std::string HttpRequest::version() const {
-    return version_;
+    return StrView();
 }
 
 // 获取POST请求中特定键对应的值
 std::string HttpRequest::GetPost(const std::string &key) const {
     assert(key != "");//确保传入的键不为空
-    if (post_.count(key) == 1) {//确保传入的键不为空
-        return post_.find(key)->second;//返回对应的值
-    }
-    return "";
+    StrView value;
+    return post_.Find(key, &value) ? value.ToString() : "";
 }
 
 std::string HttpRequest::GetPost(const char *key) const {
     assert(key != nullptr);
-    if (post_.count(key) == 1) {
-        return post_.find(key)->second;
+    StrView value;
+    return post_.Find(key, &value) ? value.ToString() : "";
+}
+
+// 获取请求头 Cookie 中名为 name 的值，格式为 a=1; b=2
+StrView HttpRequest::GetCookie(const char *name) const {
+    assert(name != nullptr);
+    StrView cookie = GetHeader("Cookie");
+    size_t len = strlen(name);
+    size_t pos = 0;
+    while (pos < cookie.len) {
+        while (pos < cookie.len && cookie.data[pos] == ' ') { pos++; }
+        const char *semi = static_cast<const char *>(memchr(cookie.data + pos, ';', cookie.len - pos));
+        size_t end = semi ? semi - cookie.data : cookie.len;
+        if (end - pos > len && memcmp(cookie.data + pos, name, len) == 0 && cookie.data[pos + len] == '=') {
+            return StrView(cookie.data + pos + len + 1, end - pos - len - 1);
+        }
+        pos = end + 1;
     }
-    return "";
-}
\ No newline at end of file
+    return StrView();
+}
@@ -6,17 +6,16 @@
 #ifndef HTTP_REQUEST_H
 #define HTTP_REQUEST_H
 
-#include <unordered_map>
-#include <unordered_set>
 #include <string>
-#include <regex>
+#include <algorithm>   // search
+#include <strings.h>   // strncasecmp
 #include <errno.h>     
-#include <mysql/mysql.h>  //mysql
 
 #include "../buffer/buffer.h"
+#include "../buffer/arena.h"
+#include "../buffer/strview.h"
 #include "../log/log.h"
-#include "../pool/sqlconnpool.h"
-#include "../pool/sqlconnRAII.h"
+#include "formdata.h"
 
 class HttpRequest {
 public:
@@ -46,15 +45,31 @@ public:
     void Init();
     bool parse(Buffer& buff);
 
-    std::string path() const;
-    std::string& path();
-    std::string method() const;
-    std::string version() const;
+    // 以下视图指向请求内存池或字符串常量，以 '\0' 结尾，在下一次 Init() 之前有效
+    StrView path() const { return path_; }
+    void SetPath(StrView path) { path_ = path; }
+    StrView method() const { return method_; }
+    StrView version() const { return version_; }
+    StrView GetHeader(StrView key) const;
     std::string GetPost(const std::string& key) const;
     std::string GetPost(const char* key) const;
+    StrView GetCookie(const char* name) const;
+
+    // 请求期间的临时内存，解析、路由与生成响应共用，在处理下一个请求时回收
+    Arena& GetArena() { return arena_; }
 
     bool IsKeepAlive() const;
 
+    // 登录或注册请求解析完成后需要查询数据库，由调用方交给数据库执行器异步校验
+    bool IsAuthPending() const { return authPending_; }
+    bool IsAuthLogin() const { return authLogin_; }
+    void FinishAuth(bool ok);
+
+    // 会话校验通过后记录的用户名，未登录时为空
+    const std::string& User() const { return user_; }
+    void SetUser(const std::string& user) { user_ = user; }
+
+
     /* 
     todo 
     void HttpConn::ParseFormData() {}
@@ -62,24 +77,34 @@ public:
     */
 
 private:
-    bool ParseRequestLine_(const std::string& line);
-    void ParseHeader_(const std::string& line);
-    void ParseBody_(const std::string& line);
+    bool ParseRequestLine_(StrView line);
+    void ParseHeader_(StrView line);
+    void ParseBody_(StrView line);
 
     void ParsePath_();
     void ParsePost_();
     void ParseFromUrlencoded_();
 
-    static bool UserVerify(const std::string& name, const std::string& pwd, bool isLogin);
+    StrView Dup_(StrView s);
+
+    static const int MAX_HEADERS = 32; // 超出的头部忽略
+
+    struct Header {
+        StrView key;
+        StrView value;
+    };
 
     PARSE_STATE state_; // 用于表示 HTTP 请求的解析状态
-    std::string method_, path_, version_, body_; //存储 HTTP 请求中的方法、路径、版本和请求体
-    std::unordered_map<std::string, std::string> header_;//头部信息
-    std::unordered_map<std::string, std::string> post_;//POST请求的数据
+    Arena arena_;//请求期间的临时内存，每个请求开始时回收
+    StrView method_, path_, version_, body_; //HTTP 请求中的方法、路径、版本和请求体，指向 arena_
+    Header header_[MAX_HEADERS];//头部信息，同名头部以最后一个为准
+    int headerCount_;
+    FormData post_;//POST请求的表单数据，视图指向 body_ 或 arena_
+    bool authPending_; // 等待数据库校验用户名与密码
+    bool authLogin_; // true 为登录，false 为注册
+    std::string user_; // 会话对应的用户名
 
-    static const std::unordered_set<std::string> DEFAULT_HTML;
-    static const std::unordered_map<std::string, int> DEFAULT_HTML_TAG;
-    static int ConverHex(char ch);
+    static const char* DEFAULT_HTML[];
 };
 
 
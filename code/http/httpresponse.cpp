@@ -7,8 +7,8 @@
 
 using namespace std;
 
-// 表示文件后缀与 MIME 类型之间的映射关系
-const unordered_map<string, string> HttpResponse::SUFFIX_TYPE = {
+// 表示文件后缀与 MIME 类型之间的映射关系，表很短，顺序比较即可，不需要构造字符串查哈希表
+const HttpResponse::SuffixType HttpResponse::SUFFIX_TYPE[] = {
     { ".html",  "text/html" },
     { ".xml",   "text/xml" },
     { ".xhtml", "application/xhtml+xml" },
@@ -30,27 +30,33 @@ const unordered_map<string, string> HttpResponse::SUFFIX_TYPE = {
     { ".js",    "text/javascript "},
 };
 
-// HTTP 状态码与状态消息之间的映射关系
-const unordered_map<int, string> HttpResponse::CODE_STATUS = {
-    { 200, "OK" },
-    { 400, "Bad Request" },
-    { 403, "Forbidden" },
-    { 404, "Not Found" },
-};
+// HTTP 状态码对应的状态消息，不认识的状态码返回 nullptr
+const char* HttpResponse::CodeStatus_(int code) {
+    switch(code) {
+    case 200: return "OK";
+    case 400: return "Bad Request";
+    case 403: return "Forbidden";
+    case 404: return "Not Found";
+    default: return nullptr;
+    }
+}
 
-//HTTP 状态码与对应错误页面路径之间的映射关系
-const unordered_map<int, string> HttpResponse::CODE_PATH = {
-    { 400, "/400.html" },
-    { 403, "/403.html" },
-    { 404, "/404.html" },
-};
+//HTTP 状态码对应的错误页面路径，没有时返回 nullptr
+const char* HttpResponse::CodePath_(int code) {
+    switch(code) {
+    case 400: return "/400.html";
+    case 403: return "/403.html";
+    case 404: return "/404.html";
+    default: return nullptr;
+    }
+}
 
 //默认构造函数
 HttpResponse::HttpResponse() {
     code_ = -1;//初始状态为未定义的状态码
-    path_ = srcDir_ = "";
+    srcDir_ = filePath_ = "";
+    arena_ = nullptr;
     isKeepAlive_ = false;//默认情况下不保持连接活动状态
-    mmFile_ = nullptr; //表示没有分配内存来保存文件内容
     mmFileStat_ = { 0 };//将 mmFileStat_ 结构体的所有成员都设置为0。
 };
 
@@ -59,22 +65,34 @@ HttpResponse::~HttpResponse() {
     UnmapFile();
 }
 
-//对 HttpResponse 对象进行初始化
-void HttpResponse::Init(const string& srcDir, string& path, bool isKeepAlive, int code){
-    assert(srcDir != "");
+//对 HttpResponse 对象进行初始化，路径与拼接出的文件路径都在请求的内存池中，不申请堆内存
+void HttpResponse::Init(const char* srcDir, StrView path, Arena& arena, bool isKeepAlive, int code){
+    assert(srcDir && *srcDir);
     if(mmFile_) { UnmapFile(); }//检查 mmFile_ 是否已分配内存,如果已经分配，则调用 UnmapFile() 函数来取消映射文件
     code_ = code;
     isKeepAlive_ = isKeepAlive;
-    path_ = path;
     srcDir_ = srcDir;
-    mmFile_ = nullptr; 
+    arena_ = &arena;
+    SetPath_(path);
+    cookie_.clear();
     mmFileStat_ = { 0 };
 }
 
+// 设置路径并在内存池中拼接出以 '\0' 结尾的文件路径
+void HttpResponse::SetPath_(StrView path) {
+    path_ = path;
+    size_t dirLen = strlen(srcDir_);
+    char* p = arena_->Alloc(dirLen + path.len + 1);
+    memcpy(p, srcDir_, dirLen);
+    memcpy(p + dirLen, path.data, path.len);
+    p[dirLen + path.len] = '\0';
+    filePath_ = p;
+}
+
 //根据请求的资源文件生成HTTP响应
-void HttpResponse::MakeResponse(Buffer& buff) {
+void HttpResponse::MakeResponse(ChainBuffer& buff) {
                                                 //判断请求的资源文件
-    if(stat((srcDir_ + path_).data(), &mmFileStat_) < 0 || S_ISDIR(mmFileStat_.st_mode)) {//调用 stat 函数来获取请求资源文件的状态信息，并将其存储在 mmFileStat_ 结构体中。如果获取失败（返回值小于0）或者请求的资源是一个目录
+    if(stat(filePath_, &mmFileStat_) < 0 || S_ISDIR(mmFileStat_.st_mode)) {//调用 stat 函数来获取请求资源文件的状态信息，并将其存储在 mmFileStat_ 结构体中。如果获取失败（返回值小于0）或者请求的资源是一个目录
         code_ = 404;//状态码设置为404（表示未找到资源）
     }
     else if(!(mmFileStat_.st_mode & S_IROTH)) {//如果请求的资源文件的权限不允许其他用户读取
@@ -85,12 +103,22 @@ void HttpResponse::MakeResponse(Buffer& buff) {
     }
     ErrorHtml_();//用于根据状态码生成对应的错误页面内容
     AddStateLine_(buff);//向缓冲区中添加 HTTP 状态行
-    AddHeader_(buff);//向缓冲区中添加 HTTP 响应头部
+    AddHeader_(buff, GetFileType_());//向缓冲区中添加 HTTP 响应头部
     AddContent_(buff);//向缓冲区中添加 HTTP 响应正文内容
 }
 
+//生成正文由程序给出的 200 响应（如 /metrics），不访问文件
+void HttpResponse::MakeBodyResponse(ChainBuffer& buff, const string& body, const char* contentType) {
+    code_ = 200;
+    AddStateLine_(buff);
+    AddHeader_(buff, contentType);
+    char line[64];
+    buff.Append(line, snprintf(line, sizeof(line), "Content-length: %zu\r\n\r\n", body.size()));
+    buff.Append(body);
+}
+
 char* HttpResponse::File() {
-    return mmFile_;
+    return mmFile_.get();
 }
 
 size_t HttpResponse::FileLen() const {
@@ -99,27 +127,26 @@ size_t HttpResponse::FileLen() const {
 
 //根据 HTTP 状态码获取相应的错误页面路径，并更新 path_ 变量以及相应的文件状态信息
 void HttpResponse::ErrorHtml_() {
-    if(CODE_PATH.count(code_) == 1) {
-        path_ = CODE_PATH.find(code_)->second;
-        stat((srcDir_ + path_).data(), &mmFileStat_);//调用 stat 函数获取该路径对应文件的状态信息，将结果存储在 mmFileStat_ 中。
+    const char* path = CodePath_(code_);
+    if(path) {
+        SetPath_(path);
+        stat(filePath_, &mmFileStat_);//调用 stat 函数获取该路径对应文件的状态信息，将结果存储在 mmFileStat_ 中。
     }
 }
 
 //向 HTTP 响应中添加状态行
-void HttpResponse::AddStateLine_(Buffer& buff) {
-    string status;//用于存储 HTTP 状态消息
-    if(CODE_STATUS.count(code_) == 1) {//检查当前的 HTTP 状态码 code_ 是否在 CODE_STATUS 映射表中
-        status = CODE_STATUS.find(code_)->second;//获取相应的状态消息
-    }
-    else {
+void HttpResponse::AddStateLine_(ChainBuffer& buff) {
+    const char* status = CodeStatus_(code_);//HTTP 状态消息
+    if(!status) {//不认识的状态码
         code_ = 400;//状态码设置为400
-        status = CODE_STATUS.find(400)->second;//获取相应的状态消息。
+        status = CodeStatus_(400);//获取相应的状态消息。
     }
-    buff.Append("HTTP/1.1 " + to_string(code_) + " " + status + "\r\n");//将 HTTP 状态行添加到缓冲区 buff 中。其中包括了 HTTP 协议版本号、状态码和状态消息。
+    char line[64];
+    buff.Append(line, snprintf(line, sizeof(line), "HTTP/1.1 %d %s\r\n", code_, status));//将 HTTP 状态行添加到缓冲区 buff 中。其中包括了 HTTP 协议版本号、状态码和状态消息。
 }
 
 //向 HTTP 响应中添加头部信息
-void HttpResponse::AddHeader_(Buffer& buff) {
+void HttpResponse::AddHeader_(ChainBuffer& buff, const char* contentType) {
     buff.Append("Connection: ");
     if(isKeepAlive_) {//检查是否需要保持连接活动状态
         buff.Append("keep-alive\r\n");//添加 Connection: keep-alive 头部
@@ -127,60 +154,79 @@ void HttpResponse::AddHeader_(Buffer& buff) {
     } else{
         buff.Append("close\r\n");//添加 Connection: close 头部，表示关闭连接。
     }
-    buff.Append("Content-type: " + GetFileType_() + "\r\n");//调用 GetFileType_() 函数获取文件类型，并将其添加到头部中。
+    buff.Append("Content-type: ");//添加正文的 MIME 类型
+    buff.Append(contentType);
+    buff.Append("\r\n");
+    if(!cookie_.empty()) {
+        buff.Append("Set-Cookie: " + cookie_ + "\r\n");//登录成功时签发的会话
+    }
 }
 
 //向HTTP响应中添加内容
-void HttpResponse::AddContent_(Buffer& buff) {
-    int srcFd = open((srcDir_ + path_).data(), O_RDONLY);//打开请求的资源文件
+void HttpResponse::AddContent_(ChainBuffer& buff) {
+    int srcFd = open(filePath_, O_RDONLY);//打开请求的资源文件
     if(srcFd < 0) { 
         ErrorContent(buff, "File NotFound!");
         return; 
     }
 
     // 将文件映射到内存提高文件的访问速度,MAP_PRIVATE建立一个写入时拷贝的私有映射
-    LOG_DEBUG("file path %s", (srcDir_ + path_).data());
-    int* mmRet = (int*)mmap(0, mmFileStat_.st_size, PROT_READ, MAP_PRIVATE, srcFd, 0);//使用mmap函数将文件映射到内存中，以提高文件的访问速度。mmap 函数返回映射到内存的起始地址，如果映射失败，则返回 -1。
-    if(*mmRet == -1) {
+    LOG_DEBUG("file path %s", filePath_);
+    size_t size = mmFileStat_.st_size;
+    if(size == 0) { // 空文件无需映射
+        close(srcFd);
+        buff.Append("Content-length: 0\r\n\r\n");
+        return;
+    }
+    void* mmRet = mmap(0, size, PROT_READ, MAP_PRIVATE, srcFd, 0);//使用mmap函数将文件映射到内存中，以提高文件的访问速度。映射失败返回 MAP_FAILED。
+    close(srcFd); // 关闭文件，映射不受影响
+    if(mmRet == MAP_FAILED) {
         ErrorContent(buff, "File NotFound!");
         return; 
     }
-    mmFile_ = (char*)mmRet;
-    close(srcFd); // 关闭文件
-    buff.Append("Content-length: " + to_string(mmFileStat_.st_size) + "\r\n\r\n");
+    // 控制块分配在请求的内存池中：写缓冲区发送完、UnmapFile() 之后才会处理下一个请求并回收内存池
+    mmFile_.reset(static_cast<char*>(mmRet), [size](char* p) { munmap(p, size); }, ArenaAllocator<char>(arena_));
+    char line[64];
+    buff.Append(line, snprintf(line, sizeof(line), "Content-length: %zu\r\n\r\n", size));
+    buff.AppendRef(mmFile_, mmFile_.get(), size); // 文件内容作为引用段追加，不拷贝
 }
 
-//取消映射之前通过 mmap 函数映射的文件
+//释放对映射文件的引用，若仍有待发送的数据段引用该映射，则在发送完后才真正 munmap
 void HttpResponse::UnmapFile() {
-    if(mmFile_) {//确保 mmFile_ 不为空
-        munmap(mmFile_, mmFileStat_.st_size);//取消对文件的内存映射
-        mmFile_ = nullptr;//取消映射后，文件指针为空
-    }
+    mmFile_.reset();
 }
 
 //根据请求的文件路径获取文件类型（MIME 类型）
-string HttpResponse::GetFileType_() {
+const char* HttpResponse::GetFileType_() const {
     /* 判断文件类型 */
-    string::size_type idx = path_.find_last_of('.');//使用 find_last_of 函数找到文件路径中最后一个 '.' 符号的位置，并将其索引存储在变量 idx 中
-    if(idx == string::npos) {//如果未找到 '.' 符号
+    const char* dot = nullptr;//文件路径中最后一个 '.' 符号的位置
+    for(size_t i = path_.len; i > 0; i--) {
+        if(path_.data[i - 1] == '.') {
+            dot = path_.data + i - 1;
+            break;
+        }
+    }
+    if(!dot) {//如果未找到 '.' 符号
         return "text/plain";
     }
-    string suffix = path_.substr(idx);//将后缀截取出来存储在变量 suffix 中。
-    if(SUFFIX_TYPE.count(suffix) == 1) {//检查文件后缀是否在 SUFFIX_TYPE 映射表中
-        return SUFFIX_TYPE.find(suffix)->second;
+    StrView suffix(dot, path_.data + path_.len - dot);//后缀
+    for(const SuffixType& item : SUFFIX_TYPE) {//检查文件后缀是否在 SUFFIX_TYPE 表中
+        if(suffix == item.suffix) {
+            return item.type;
+        }
     }
     return "text/plain";
 }
 
 // 生成 HTTP 响应的错误内容，并将其添加到指定的缓冲区中。
-void HttpResponse::ErrorContent(Buffer& buff, string message) 
+void HttpResponse::ErrorContent(ChainBuffer& buff, string message) 
 {
     string body;//用于存储 HTML 错误页面的内容。
     string status;
     body += "<html><title>Error</title>";//向 body 中添加了 HTML 标签，包括标题、背景颜色等。
     body += "<body bgcolor=\"ffffff\">";
-    if(CODE_STATUS.count(code_) == 1) {//检查当前的 HTTP 状态码 code_ 是否在 CODE_STATUS 映射表中
-        status = CODE_STATUS.find(code_)->second;//获取相应的状态消息
+    if(CodeStatus_(code_)) {//检查当前的 HTTP 状态码 code_ 是否认识
+        status = CodeStatus_(code_);//获取相应的状态消息
     } else {
         status = "Bad Request";//默认为 "Bad Request"
     }
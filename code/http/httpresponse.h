@@ -6,13 +6,17 @@
 #ifndef HTTP_RESPONSE_H
 #define HTTP_RESPONSE_H
 
-#include <unordered_map>
+#include <string>
+#include <stdio.h>       // snprintf
+#include <memory>
 #include <fcntl.h>       // open
 #include <unistd.h>      // close
 #include <sys/stat.h>    // stat
 #include <sys/mman.h>    // mmap, munmap
 
-#include "../buffer/buffer.h"
+#include "../buffer/chainbuffer.h"
+#include "../buffer/arena.h"
+#include "../buffer/strview.h"
 #include "../log/log.h"
 
 class HttpResponse {
@@ -20,34 +24,45 @@ public:
     HttpResponse();
     ~HttpResponse();
 
-    void Init(const std::string& srcDir, std::string& path, bool isKeepAlive = false, int code = -1);
-    void MakeResponse(Buffer& buff);
+    void Init(const char* srcDir, StrView path, Arena& arena, bool isKeepAlive = false, int code = -1);
+    void MakeResponse(ChainBuffer& buff);
+    void MakeBodyResponse(ChainBuffer& buff, const std::string& body, const char* contentType);
     void UnmapFile();
     char* File();
     size_t FileLen() const;
-    void ErrorContent(Buffer& buff, std::string message);
+    void ErrorContent(ChainBuffer& buff, std::string message);
     int Code() const { return code_; }
+    void SetCookie(const std::string& cookie) { cookie_ = cookie; }
 
 private:
-    void AddStateLine_(Buffer &buff);
-    void AddHeader_(Buffer &buff);
-    void AddContent_(Buffer &buff);
+    void AddStateLine_(ChainBuffer &buff);
+    void AddHeader_(ChainBuffer &buff, const char* contentType);
+    void AddContent_(ChainBuffer &buff);
 
     void ErrorHtml_();
-    std::string GetFileType_();
+    void SetPath_(StrView path);
+    const char* GetFileType_() const;
+
+    static const char* CodeStatus_(int code);
+    static const char* CodePath_(int code);
 
     int code_;//表示某种代码或状态
     bool isKeepAlive_;//表示是否保持连接活动状态
 
-    std::string path_;//保存路径
-    std::string srcDir_;//源目录
+    StrView path_;//请求的路径，指向请求的内存池或字符串常量
+    const char* srcDir_;//源目录
+    const char* filePath_;//源目录与路径拼接成的文件路径，分配在内存池中
+    Arena* arena_;//所属请求的内存池，本轮响应的临时数据都分配在其中
+    std::string cookie_;//Set-Cookie 头部的值，为空时不发送
     
-    char* mmFile_; //操作文件内容
+    std::shared_ptr<char> mmFile_; //操作文件内容，引用计数归零时 munmap，发送中的数据段也持有引用；控制块分配在内存池中
     struct stat mmFileStat_;//存储文件的状态信息
 
-    static const std::unordered_map<std::string, std::string> SUFFIX_TYPE;
-    static const std::unordered_map<int, std::string> CODE_STATUS;
-    static const std::unordered_map<int, std::string> CODE_PATH;
+    struct SuffixType {
+        const char* suffix;
+        const char* type;
+    };
+    static const SuffixType SUFFIX_TYPE[];
 };
 
 
@@ -0,0 +1,244 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#include "accesslog.h"
+
+using namespace std;
+
+const char* AccessLog::LOG_NAME = "access.log";
+const int AccessLog::FLUSH_INTERVAL_MS;
+
+namespace {
+// 每个线程独占一个访问日志缓冲区，线程退出时标记为已脱离
+struct AccessRingHolder {
+    shared_ptr<LogRing> ring;
+    ~AccessRingHolder() {
+        if(ring) { ring->Detach(); }
+    }
+};
+
+thread_local AccessRingHolder accessRing;
+
+// 追加 JSON 字符串内容，转义引号、反斜杠与控制字符
+void AppendJsonString(Buffer& buff, const char* s, size_t maxLen) {
+    static const char HEX[] = "0123456789abcdef";
+    for(size_t i = 0; i < maxLen && s[i]; i++) {
+        unsigned char c = static_cast<unsigned char>(s[i]);
+        if(c == '"' || c == '\\') {
+            char esc[2] = { '\\', static_cast<char>(c) };
+            buff.Append(esc, 2);
+        } else if(c < 0x20) {
+            char esc[6] = { '\\', 'u', '0', '0', HEX[c >> 4], HEX[c & 0xf] };
+            buff.Append(esc, 6);
+        } else {
+            buff.Append(reinterpret_cast<const char*>(&c), 1);
+        }
+    }
+}
+}
+
+// 构造函数
+AccessLog::AccessLog() : maxFileBytes_(0), rotateSec_(0), fd_(-1), fileBytes_(0), openedAt_(0), rotateSeq_(0),
+    isOpen_(false), isClosing_(false), wakeRequested_(false), dropped_(0), ringBytes_(0) {}
+
+// 析构函数
+AccessLog::~AccessLog() {
+    Close();
+}
+
+// 获取单例
+AccessLog* AccessLog::Instance() {
+    static AccessLog inst;
+    return &inst;
+}
+
+// 初始化：打开当前文件并启动后台线程，重复调用无效
+void AccessLog::init(const char* path, size_t maxFileBytes, int rotateSec, size_t ringBytes) {
+    assert(path && maxFileBytes > 0 && rotateSec >= 0 && ringBytes > sizeof(AccessRecord));
+    if(isOpen_) { return; }
+    path_ = path;
+    maxFileBytes_ = maxFileBytes;
+    rotateSec_ = rotateSec;
+    ringBytes_ = ringBytes;
+    OpenFile_();
+    isClosing_ = false;
+    isOpen_ = true;
+    writeThread_.reset(new thread(&AccessLog::BackgroundWrite_, this));
+}
+
+// 关闭：后台线程写完所有缓冲的记录后退出
+void AccessLog::Close() {
+    if(!isOpen_.exchange(false)) { return; }
+    isClosing_ = true;
+    {
+        lock_guard<mutex> locker(condMtx_);
+    }
+    cond_.notify_one();
+    if(writeThread_ && writeThread_->joinable()) {
+        writeThread_->join();
+    }
+    writeThread_.reset();
+    if(fd_ >= 0) {
+        close(fd_);
+        fd_ = -1;
+    }
+}
+
+// 以追加方式打开当前文件，目录不存在时先创建
+void AccessLog::OpenFile_() {
+    string name = path_ + "/" + LOG_NAME;
+    fd_ = open(name.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if(fd_ < 0) {
+        mkdir(path_.c_str(), 0777);
+        fd_ = open(name.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    }
+    assert(fd_ >= 0);
+    struct stat st;
+    fileBytes_ = fstat(fd_, &st) == 0 ? static_cast<size_t>(st.st_size) : 0;
+    openedAt_ = time(nullptr);
+}
+
+// 当前文件超过大小上限或打开时间超过切换间隔时，改名归档并打开新文件；只在后台线程调用
+void AccessLog::RotateIfNeeded_(time_t now) {
+    if(fileBytes_ == 0) { return; }
+    if(fileBytes_ < maxFileBytes_ && (rotateSec_ == 0 || now - openedAt_ < rotateSec_)) { return; }
+    struct tm t;
+    localtime_r(&now, &t);
+    char archive[80];
+    snprintf(archive, sizeof(archive), "access-%04d%02d%02d-%02d%02d%02d-%u.log", // 序号避免同一秒内切换多次时覆盖
+             t.tm_year + 1900, t.tm_mon + 1, t.tm_mday, t.tm_hour, t.tm_min, t.tm_sec, ++rotateSeq_);
+    string from = path_ + "/" + LOG_NAME;
+    string to = path_ + "/" + archive;
+    close(fd_);
+    rename(from.c_str(), to.c_str());
+    OpenFile_();
+}
+
+// 返回当前线程的缓冲区，首次使用时创建并登记
+LogRing* AccessLog::LocalRing_() {
+    if(!accessRing.ring) {
+        accessRing.ring = make_shared<LogRing>(ringBytes_);
+        lock_guard<mutex> locker(ringMtx_);
+        rings_.push_back(accessRing.ring);
+    }
+    return accessRing.ring.get();
+}
+
+// 追加一条访问记录：只做一次定长拷贝，缓冲区放不下时丢弃并计数，从不阻塞
+void AccessLog::Append(const AccessRecord& rec) {
+    if(!IsOpen()) { return; }
+    LogRing* ring = LocalRing_();
+    if(!ring->TryPush(reinterpret_cast<const char*>(&rec), sizeof(rec))) {
+        dropped_.fetch_add(1, memory_order_relaxed);
+        return;
+    }
+    size_t readable = ring->ProducerReadable();
+    if(readable >= FLUSH_BYTES && readable - sizeof(rec) < FLUSH_BYTES
+        && !wakeRequested_.exchange(true)) {
+        {
+            lock_guard<mutex> locker(condMtx_);
+        }
+        cond_.notify_one();
+    }
+}
+
+// 把一条记录格式化成一行 JSON 追加到 textBuff_
+void AccessLog::FormatRecord_(const AccessRecord& rec) {
+    static thread_local time_t cachedSec = -1;
+    static thread_local char cachedPrefix[64];
+    time_t sec = rec.timeUs / 1000000;
+    if(sec != cachedSec) { // 同一秒内的记录复用日期时间前缀
+        struct tm t;
+        localtime_r(&sec, &t);
+        snprintf(cachedPrefix, sizeof(cachedPrefix), "%04d-%02d-%02dT%02d:%02d:%02d",
+                 t.tm_year + 1900, t.tm_mon + 1, t.tm_mday, t.tm_hour, t.tm_min, t.tm_sec);
+        cachedSec = sec;
+    }
+    char ip[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET, &rec.ip, ip, sizeof(ip));
+
+    char head[160];
+    int n = snprintf(head, sizeof(head), "{\"time\":\"%s.%06ld\",\"client\":\"%s:%u\",\"method\":\"",
+                     cachedPrefix, static_cast<long>(rec.timeUs % 1000000), ip, rec.port);
+    textBuff_.Append(head, n);
+    AppendJsonString(textBuff_, rec.method, sizeof(rec.method));
+    textBuff_.Append("\",\"path\":\"", 10);
+    AppendJsonString(textBuff_, rec.path, sizeof(rec.path));
+    char tail[160];
+    n = snprintf(tail, sizeof(tail),
+                 "\",\"status\":%u,\"bytes\":%llu,\"latency_us\":%lld,\"seq\":%u,\"keep_alive\":%s}\n",
+                 rec.status, static_cast<unsigned long long>(rec.bytes),
+                 static_cast<long long>(rec.latencyUs), rec.seq, rec.keepAlive ? "true" : "false");
+    textBuff_.Append(tail, n);
+}
+
+// 取出所有线程缓冲区中的记录，格式化后一次写出；返回是否写出了数据
+bool AccessLog::DrainRings_() {
+    vector<shared_ptr<LogRing>> rings;
+    {
+        lock_guard<mutex> locker(ringMtx_);
+        // 回收所属线程已退出且已读空的缓冲区
+        rings_.erase(remove_if(rings_.begin(), rings_.end(), [](const shared_ptr<LogRing>& r) {
+            return r->IsDetached() && r->ReadableBytes() == 0;
+        }), rings_.end());
+        rings = rings_;
+    }
+    RotateIfNeeded_(time(nullptr));
+    for(auto& ring : rings) {
+        struct iovec iov[2];
+        int segs = ring->Peek(iov, SIZE_MAX);
+        size_t avail = 0;
+        for(int i = 0; i < segs; i++) { avail += iov[i].iov_len; }
+        size_t cnt = avail / sizeof(AccessRecord); // 环中只有完整的记录
+        for(size_t k = 0; k < cnt; k++) {
+            AccessRecord rec;
+            size_t off = k * sizeof(AccessRecord);
+            char* dst = reinterpret_cast<char*>(&rec);
+            size_t len = sizeof(AccessRecord);
+            for(int i = 0; i < segs && len > 0; i++) { // 记录可能跨越环尾
+                if(off >= iov[i].iov_len) { off -= iov[i].iov_len; continue; }
+                size_t n = min(len, iov[i].iov_len - off);
+                memcpy(dst, static_cast<const char*>(iov[i].iov_base) + off, n);
+                dst += n;
+                len -= n;
+                off = 0;
+            }
+            FormatRecord_(rec);
+        }
+        ring->Consume(cnt * sizeof(AccessRecord));
+    }
+    size_t total = textBuff_.ReadableBytes();
+    if(total == 0) { return false; }
+    const char* p = textBuff_.Peek();
+    size_t left = total;
+    while(left > 0) {
+        ssize_t n = ::write(fd_, p, left);
+        if(n < 0) {
+            if(errno == EINTR) { continue; }
+            break; // 磁盘错误时丢弃这一批
+        }
+        p += n;
+        left -= n;
+    }
+    fileBytes_ += total;
+    textBuff_.RetrieveAll();
+    return true;
+}
+
+// 后台线程：按周期或积压越过阈值时批量写出，退出前写完所有记录
+void AccessLog::BackgroundWrite_() {
+    while(true) {
+        {
+            unique_lock<mutex> locker(condMtx_);
+            cond_.wait_for(locker, chrono::milliseconds(FLUSH_INTERVAL_MS), [this] {
+                return isClosing_.load() || wakeRequested_.load();
+            });
+        }
+        bool closing = isClosing_.load();
+        wakeRequested_ = false;
+        while(DrainRings_()) {}
+        if(closing) { break; }
+    }
+}
@@ -0,0 +1,101 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#ifndef ACCESSLOG_H
+#define ACCESSLOG_H
+
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <algorithm>
+#include <time.h>
+#include <fcntl.h>            // open
+#include <unistd.h>           // write, close
+#include <stdio.h>            // rename
+#include <sys/stat.h>         // mkdir
+#include <arpa/inet.h>        // inet_ntop
+#include <assert.h>
+#include <errno.h>
+#include <stdint.h>           // SIZE_MAX
+#include "logring.h"
+#include "../buffer/buffer.h"
+
+// 一条访问日志：定长，写日志的线程只做一次拷贝，格式化由后台线程完成
+struct AccessRecord {
+    int64_t timeUs;      // 请求开始处理的墙上时间（微秒）
+    int64_t latencyUs;   // 从开始处理到响应最后一个字节写出的耗时（微秒）
+    uint64_t bytes;      // 响应字节数（响应头与正文）
+    uint32_t ip;         // 客户端地址，网络字节序
+    uint16_t port;       // 客户端端口
+    uint16_t status;     // 响应状态码
+    uint32_t seq;        // 本连接上的第几个请求，大于 1 表示连接被复用
+    uint8_t keepAlive;   // 响应后是否保持连接
+    char method[8];      // 请求方法
+    char path[128];      // 请求路径，超长截断
+};
+
+// 结构化访问日志：每个线程把定长记录无锁放入自己的环形缓冲区，
+// 后台线程批量格式化成 JSON 行，以 O_APPEND 一次写出，并按大小与时间切换文件
+class AccessLog {
+public:
+    static AccessLog* Instance();
+
+    void init(const char* path = "./log", size_t maxFileBytes = 64 * 1024 * 1024,
+              int rotateSec = 3600, size_t ringBytes = 256 * 1024);
+
+    bool IsOpen() const { return isOpen_.load(std::memory_order_relaxed); }
+
+    void Append(const AccessRecord& rec);
+
+    void Close();
+
+    uint64_t GetDropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    AccessLog();
+    ~AccessLog();
+
+    LogRing* LocalRing_();
+    void BackgroundWrite_();
+    bool DrainRings_();
+    void FormatRecord_(const AccessRecord& rec);
+    void RotateIfNeeded_(time_t now);
+    void OpenFile_();
+
+    static const char* LOG_NAME; // 当前写入的文件名，切换时改名为带时间的归档文件
+    static const int FLUSH_INTERVAL_MS = 200; // 后台线程最长的批量间隔
+    static const size_t FLUSH_BYTES = 32 * 1024; // 某个线程积压越过该值时提前唤醒后台线程
+
+    std::string path_;
+    size_t maxFileBytes_; // 单个文件的最大字节数
+    int rotateSec_; // 按时间切换的间隔（秒），0 表示只按大小切换
+
+    int fd_; // 当前文件，只由后台线程访问
+    size_t fileBytes_; // 当前文件已写入的字节数
+    time_t openedAt_; // 当前文件打开的时间
+    unsigned int rotateSeq_; // 归档文件序号
+
+    std::atomic<bool> isOpen_;
+    std::atomic<bool> isClosing_;
+    std::atomic<bool> wakeRequested_;
+    std::atomic<uint64_t> dropped_; // 缓冲区放不下而丢弃的记录数
+
+    size_t ringBytes_;
+    std::vector<std::shared_ptr<LogRing>> rings_;
+    std::mutex ringMtx_; // 保护 rings_ 的注册与遍历
+
+    std::mutex condMtx_;
+    std::condition_variable cond_;
+    std::unique_ptr<std::thread> writeThread_;
+
+    Buffer textBuff_; // 批量格式化的输出，只由后台线程访问
+};
+
+#endif //ACCESSLOG_H
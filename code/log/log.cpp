@@ -2,195 +2,531 @@
  * @Author       : mark
  * @Date         : 2020-06-16
  * @copyleft Apache 2.0
- */ 
+ */
 #include "log.h"
 
 using namespace std;
 
+const size_t Log::MIN_RING_SIZE;
+const size_t Log::FLUSH_BYTES;
+const int Log::FLUSH_INTERVAL_MS;
+constexpr int Log::LEVEL_WATERMARK[];
+
+namespace {
+// 每个线程独占一个环形缓冲区，线程退出时标记为已脱离，由后台线程读空后回收
+struct LocalRingHolder {
+    shared_ptr<LogRing> ring;
+    ~LocalRingHolder() {
+        if(ring) { ring->Detach(); }
+    }
+};
+
+thread_local LocalRingHolder localRing;
+
+// 每个线程缓存当前这一秒的本地时间与 "YYYY-MM-DD hh:mm:ss." 前缀，
+// 同一秒内的日志只需改写微秒部分，localtime_r 每秒最多调用一次
+struct TimeCache {
+    time_t sec = -1;
+    struct tm t;
+    char prefix[24];
+    int prefixLen = 0;
+};
+
+thread_local TimeCache timeCache;
+
+// 返回 sec 对应的本地时间，秒数变化时才重新计算
+const struct tm& CachedLocalTime(time_t sec) {
+    TimeCache& c = timeCache;
+    if(c.sec != sec) {
+        localtime_r(&sec, &c.t);
+        c.prefixLen = snprintf(c.prefix, sizeof(c.prefix), "%d-%02d-%02d %02d:%02d:%02d.",
+                c.t.tm_year + 1900, c.t.tm_mon + 1, c.t.tm_mday,
+                c.t.tm_hour, c.t.tm_min, c.t.tm_sec);
+        c.sec = sec;
+    }
+    return c.t;
+}
+
+// 写入 "YYYY-MM-DD hh:mm:ss.uuuuuu " 形式的时间，返回写入的字节数
+int FormatTime(char* buf, time_t sec, long usec) {
+    CachedLocalTime(sec);
+    const TimeCache& c = timeCache;
+    memcpy(buf, c.prefix, c.prefixLen);
+    char* p = buf + c.prefixLen;
+    for(int i = 5; i >= 0; i--) { // 固定 6 位的微秒，从低位往高位写
+        p[i] = static_cast<char>('0' + usec % 10);
+        usec /= 10;
+    }
+    p[6] = ' ';
+    return c.prefixLen + 7;
+}
+
+// 从最多两段的 iovec 中偏移 off 处拷贝 len 字节
+void CopyOut(const struct iovec* iov, int segs, size_t off, char* dst, size_t len) {
+    for(int i = 0; i < segs && len > 0; i++) {
+        if(off >= iov[i].iov_len) {
+            off -= iov[i].iov_len;
+            continue;
+        }
+        size_t n = min(len, iov[i].iov_len - off);
+        memcpy(dst, static_cast<const char*>(iov[i].iov_base) + off, n);
+        dst += n;
+        len -= n;
+        off = 0;
+    }
+}
+}
+
 // 默认构造函数
 Log::Log() {
     lineCount_ = 0; // 记录当前日志文件中的行数
+    nextRotateLine_ = MAX_LINES; // 下一次按行数切换文件的位置
     isAsync_ = false; // 默认不启用异步写日志
+    isBinary_ = false;
+    isOpen_ = false;
+    level_ = 1;
     writeThread_ = nullptr; // 异步写日志的线程对象
-    deque_ = nullptr; // 异步写日志时的日志队列
     toDay_ = 0; // 记录上一次记录日志的日期
-    fp_ = nullptr; // 指向当前日志文件的文件指针
+    fd_ = -1; // 当前日志文件的文件描述符
+    ringSize_ = MIN_RING_SIZE;
+    isClosing_ = false;
+    flushRequested_ = false;
+    policy_ = DROP_LOW_LEVEL;
+    blockTimeoutMs_ = 10;
+    spaceWaiters_ = 0;
+    for(int i = 0; i < LEVEL_NUM; i++) { dropped_[i] = 0; }
+    reportedDrops_ = 0;
 }
 
-
-// 析构函数
+// 析构函数，通知后台线程写出所有线程缓冲区中剩余的日志后退出
 Log::~Log() {
-    if(writeThread_ && writeThread_->joinable()) { // 检查异步写日志线程是否可加入
-        while(!deque_->empty()) { // 循环刷新日志队列，确保队列中的所有日志消息都被写入到日志文件中。
-            deque_->flush();
-        };
-        deque_->Close(); // 关闭日志队列，释放相关资源
+    if(writeThread_ && writeThread_->joinable()) {
+        isClosing_ = true;
+        {
+            lock_guard<mutex> locker(condMtx_);
+        }
+        cond_.notify_one();
         writeThread_->join(); // 等待异步写日志线程结束
     }
-    if(fp_) {
+    if(fd_ >= 0) {
         lock_guard<mutex> locker(mtx_);
-        flush(); // 刷新日志缓冲区
-        fclose(fp_); // 关闭日志文件
+        close(fd_); // 关闭日志文件
+        fd_ = -1;
     }
 }
 
 // 获取日志的当前记录级别
 int Log::GetLevel() {
-    lock_guard<mutex> locker(mtx_);
-    return level_;
+    return level_.load(memory_order_relaxed);
 }
 
 // 设置日志的当前记录级别
 void Log::SetLevel(int level) {
-    lock_guard<mutex> locker(mtx_);
-    level_ = level;
+    level_.store(level, memory_order_relaxed);
 }
 
 // 初始化日志记录器
 void Log::init(int level = 1, const char* path, const char* suffix,
-    int maxQueueSize) {
+    int maxQueueSize, bool binary) {
+    DrainRings_(); // 重新初始化前按原来的模式把已缓冲的日志写入原来的文件
     isOpen_ = true; // 表示日志记录器已经打开
-    level_ = level; // 将日志级别设置为传入的 level 值
+    SetLevel(level); // 将日志级别设置为传入的 level 值
     if(maxQueueSize > 0) {
         isAsync_ = true; // 启用异步日志记录
-        if(!deque_) { // 检查是否已经创建了日志队列 deque_
-            unique_ptr<BlockDeque<std::string>> newDeque(new BlockDeque<std::string>); // 创建一个新的 BlockDeque<std::string> 对象
-            deque_ = move(newDeque); // 将其移动到 deque_ 成员变量中
-            
-            std::unique_ptr<std::thread> NewThread(new thread(FlushLogThread)); // 创建一个新的线程用于异步刷新日志
+        // 按平均行长把队列容量换算成每个线程环形缓冲区的字节数，只影响之后新建的缓冲区
+        ringSize_ = max(static_cast<size_t>(maxQueueSize) * AVG_LINE_LEN, MIN_RING_SIZE);
+        if(!writeThread_) {
+            std::unique_ptr<std::thread> NewThread(new thread(FlushLogThread)); // 创建一个新的线程用于异步写日志
             writeThread_ = move(NewThread);
         }
     } else {
         isAsync_ = false;
     }
-
-    lineCount_ = 0; // 表示当前日志行数为 0。
+    isBinary_ = binary && isAsync_;
 
     time_t timer = time(nullptr); // 获取当前系统时间
-    struct tm *sysTime = localtime(&timer);
-    struct tm t = *sysTime;
+    struct tm t;
+    localtime_r(&timer, &t);
     path_ = path;
     suffix_ = suffix;
     char fileName[LOG_NAME_LEN] = {0};
-    snprintf(fileName, LOG_NAME_LEN - 1, "%s/%04d_%02d_%02d%s", 
+    snprintf(fileName, LOG_NAME_LEN - 1, "%s/%04d_%02d_%02d%s",
             path_, t.tm_year + 1900, t.tm_mon + 1, t.tm_mday, suffix_);
-    toDay_ = t.tm_mday;
 
     {
         lock_guard<mutex> locker(mtx_); // 进行加锁
-        buff_.RetrieveAll(); // 清空日志缓冲区
-        if(fp_) { 
-            flush(); // 刷新日志文件
-            fclose(fp_); // 关闭之前的日志文件（如果已打开）
+        toDay_ = t.tm_mday;
+        lineCount_ = 0; // 表示当前日志行数为 0。
+        nextRotateLine_ = MAX_LINES;
+        OpenFile_(fileName);
+    }
+}
+
+// 以追加方式打开日志文件，替换当前文件，目录不存在时先创建；调用方需持有 mtx_
+void Log::OpenFile_(const char* fileName) {
+    if(fd_ >= 0) {
+        close(fd_); // 关闭之前的日志文件（如果已打开）
+    }
+    fd_ = open(fileName, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if(fd_ < 0) {
+        mkdir(path_, 0777); // 创建日志文件所在的目录
+        fd_ = open(fileName, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    }
+    assert(fd_ >= 0); // 确保日志文件已经成功打开
+}
+
+// 日期变化或行数达到上限时切换到新的日志文件；调用方需持有 mtx_
+void Log::RotateIfNeeded_(const struct tm& t) {
+    if(toDay_ == t.tm_mday && lineCount_ < nextRotateLine_) {
+        return;
+    }
+    char newFile[LOG_NAME_LEN]; // 生成新的日志文件名
+    char tail[36] = {0};
+    snprintf(tail, 36, "%04d_%02d_%02d", t.tm_year + 1900, t.tm_mon + 1, t.tm_mday);
+
+    if (toDay_ != t.tm_mday) // 如果当前日期与上一次记录日志的日期不同
+    {
+        snprintf(newFile, LOG_NAME_LEN - 72, "%s/%s%s", path_, tail, suffix_);
+        toDay_ = t.tm_mday;
+        lineCount_ = 0;
+        nextRotateLine_ = MAX_LINES;
+    }
+    else {
+        snprintf(newFile, LOG_NAME_LEN - 72, "%s/%s-%d%s", path_, tail, (lineCount_  / MAX_LINES), suffix_);
+        nextRotateLine_ = (lineCount_ / MAX_LINES + 1) * MAX_LINES;
+    }
+    OpenFile_(newFile);
+}
+
+// 把 iovec 数组中的内容全部写入日志文件，处理部分写入与信号中断；调用方需持有 mtx_
+void Log::WriteAll_(const struct iovec* iov, int cnt) {
+    struct iovec vec[IOV_MAX];
+    assert(cnt <= IOV_MAX);
+    memcpy(vec, iov, sizeof(struct iovec) * cnt);
+    struct iovec* cur = vec;
+    while(cnt > 0) {
+        ssize_t n = writev(fd_, cur, cnt);
+        if(n < 0) {
+            if(errno == EINTR) { continue; }
+            return; // 磁盘错误时丢弃这一批，避免后台线程卡死
+        }
+        while(cnt > 0 && static_cast<size_t>(n) >= cur->iov_len) {
+            n -= cur->iov_len;
+            cur++;
+            cnt--;
+        }
+        if(cnt > 0) {
+            cur->iov_base = static_cast<char*>(cur->iov_base) + n;
+            cur->iov_len -= n;
         }
+    }
+}
+
+// 返回当前线程的环形缓冲区，首次写日志时创建并登记到后台线程的列表中
+LogRing* Log::LocalRing_() {
+    if(!localRing.ring) {
+        localRing.ring = make_shared<LogRing>(ringSize_);
+        lock_guard<mutex> locker(ringMtx_);
+        rings_.push_back(localRing.ring);
+    }
+    return localRing.ring.get();
+}
 
-        fp_ = fopen(fileName, "a"); // 然后打开新的日志文件
-        if(fp_ == nullptr) {
-            mkdir(path_, 0777); // 创建日志文件所在的目录
-            fp_ = fopen(fileName, "a");
-        } 
-        assert(fp_ != nullptr); // 确保日志文件已经成功打开
+// 放入本线程的环形缓冲区，积压刚越过阈值时唤醒后台线程；放不下时按溢出策略丢弃或限时等待，
+// 写日志的线程永远不会等待磁盘 IO。返回 false 表示这条日志被丢弃
+bool Log::Push_(const char* data, size_t len, int level) {
+    LogRing* ring = LocalRing_();
+    int idx = level < 0 ? 0 : min(level, LEVEL_NUM - 1);
+    OverflowPolicy policy = policy_.load(memory_order_relaxed);
+    bool pushed = false;
+    if(policy == DROP_LOW_LEVEL && idx < LEVEL_NUM - 1
+        && !ring->Fits(len, ring->Capacity() / 100 * LEVEL_WATERMARK[idx])) {
+        pushed = false; // 积压超过该级别的水位线，优先丢弃低级别日志，为高级别日志保留空间
+    } else {
+        pushed = ring->TryPush(data, len);
     }
+    if(!pushed && policy == BLOCK_TIMEOUT) {
+        WakeWriter_();
+        auto deadline = chrono::steady_clock::now() + chrono::milliseconds(blockTimeoutMs_.load(memory_order_relaxed));
+        unique_lock<mutex> locker(spaceMtx_);
+        spaceWaiters_++;
+        pushed = spaceCond_.wait_until(locker, deadline, [&] { return ring->TryPush(data, len); });
+        spaceWaiters_--;
+    }
+    if(!pushed) {
+        dropped_[idx].fetch_add(1, memory_order_relaxed);
+        WakeWriter_();
+        return false;
+    }
+    size_t threshold = min(FLUSH_BYTES, ring->Capacity() / 2);
+    size_t readable = ring->ProducerReadable(); // 按缓存的读取位置估算，不读取消费者的缓存行
+    if(readable >= threshold && readable - len < threshold) {
+        WakeWriter_(); // 避免等到下一个刷新周期
+    }
+    return true;
 }
 
-// 写入日志
+// 设置异步模式下缓冲区放不下时的处理策略
+void Log::SetOverflowPolicy(OverflowPolicy policy, int blockTimeoutMs) {
+    assert(blockTimeoutMs >= 0);
+    blockTimeoutMs_ = blockTimeoutMs;
+    policy_ = policy;
+}
+
+// 返回某一级别因缓冲区放不下而丢弃的日志条数
+uint64_t Log::GetDropped(int level) const {
+    assert(level >= 0 && level < LEVEL_NUM);
+    return dropped_[level].load(memory_order_relaxed);
+}
+
+// 所有级别丢弃的日志总条数
+uint64_t Log::GetDroppedTotal() const {
+    uint64_t total = 0;
+    for(int i = 0; i < LEVEL_NUM; i++) { total += dropped_[i].load(memory_order_relaxed); }
+    return total;
+}
+
+// 各线程缓冲区中尚未写出的字节数之和，供监控读取
+size_t Log::GetQueuedBytes() {
+    lock_guard<mutex> locker(ringMtx_);
+    size_t total = 0;
+    for(auto& ring : rings_) { total += ring->ReadableBytes(); }
+    return total;
+}
+
+// 后台线程发现新的丢弃时写一行告警，说明这段时间丢了多少条日志；调用方需持有 mtx_
+void Log::ReportDropped_() {
+    uint64_t total = GetDroppedTotal();
+    if(total == reportedDrops_) { return; }
+    char line[256];
+    struct timeval now = {0, 0};
+    gettimeofday(&now, nullptr);
+    int n = FormatTime(line, now.tv_sec, now.tv_usec);
+    n += AppendLogLevelTitle_(line + n, 2);
+    n += snprintf(line + n, sizeof(line) - n - 1, "log buffer overflow, %llu lines dropped (debug:%llu info:%llu warn:%llu error:%llu)\n",
+            static_cast<unsigned long long>(total - reportedDrops_),
+            static_cast<unsigned long long>(GetDropped(0)), static_cast<unsigned long long>(GetDropped(1)),
+            static_cast<unsigned long long>(GetDropped(2)), static_cast<unsigned long long>(GetDropped(3)));
+    struct iovec iov = { line, static_cast<size_t>(n) };
+    WriteAll_(&iov, 1);
+    lineCount_++;
+    reportedDrops_ = total;
+}
+
+// 写入日志：在栈上格式化成一整行，异步模式下无锁放入本线程的环形缓冲区；
+// 二进制模式下只格式化消息，时间与级别留给后台线程
 void Log::write(int level, const char *format, ...) {
+    va_list vaList; // 存储可变参数列表
+    if(isBinary_) {
+        char rec[LOG_LINE_LEN];
+        va_start(vaList, format);
+        size_t len = LogRecord::EncodeText(rec, LOG_LINE_LEN, level, format, vaList);
+        va_end(vaList);
+        Push_(rec, len, level);
+        return;
+    }
+
     struct timeval now = {0, 0};
     gettimeofday(&now, nullptr); // 获取当前时间，将结果存储在 now 变量中
-    time_t tSec = now.tv_sec; // 从 now 结构体中提取秒数
-    struct tm *sysTime = localtime(&tSec); // 使用 localtime 函数将秒数转换为本地时间，并将结果存储在 sysTime 指针变量中
-    struct tm t = *sysTime;
-    va_list vaList; // 存储可变参数列表
 
-    /* 日志日期 日志行数 */
-    if (toDay_ != t.tm_mday || (lineCount_ && (lineCount_  %  MAX_LINES == 0))) // 如果当前日期与上一次记录日志的日期不同，或者当前日志行数达到了预设的最大行数 MAX_LINES
-    {
-        unique_lock<mutex> locker(mtx_); // 创建了一个 unique_lock 对象 locker
-        locker.unlock(); // 进行解锁操作
-        
-        char newFile[LOG_NAME_LEN]; // 生成新的日志文件名
-        char tail[36] = {0};
-        snprintf(tail, 36, "%04d_%02d_%02d", t.tm_year + 1900, t.tm_mon + 1, t.tm_mday);
-
-        if (toDay_ != t.tm_mday) // 如果当前日期与上一次记录日志的日期不同
-        {
-            snprintf(newFile, LOG_NAME_LEN - 72, "%s/%s%s", path_, tail, suffix_);
-            toDay_ = t.tm_mday;
-            lineCount_ = 0;
-        }
-        else {
-            snprintf(newFile, LOG_NAME_LEN - 72, "%s/%s-%d%s", path_, tail, (lineCount_  / MAX_LINES), suffix_);
-        }
-        
-        locker.lock(); // 进行加锁
-        flush(); // 将日志缓冲区中的内容写入到文件中
-        fclose(fp_); // 关闭当前日志文件
-        fp_ = fopen(newFile, "a"); // 打开或创建新的日志文件，以追加写入模式（"a"）
-        assert(fp_ != nullptr); // 检查文件是否成功打开
+    char line[LOG_LINE_LEN];
+    int n = FormatTime(line, now.tv_sec, now.tv_usec); // 使用本线程缓存的日期前缀，只改写微秒
+    n += AppendLogLevelTitle_(line + n, level); // 在日志消息中添加日志级别的标题
+
+    va_start(vaList, format); // 初始化一个va_list对象，它表示了参数列表中可变参数的起始位置
+    int m = vsnprintf(line + n, LOG_LINE_LEN - n - 1, format, vaList); // 根据指定的格式format以及可变参数列表vaList来格式化字符串
+    va_end(vaList); // 结束对可变参数列表的访问
+    if(m > 0) {
+        n += min(m, LOG_LINE_LEN - n - 2); // 超长的消息被截断
     }
+    line[n++] = '\n';
 
-    {
-        unique_lock<mutex> locker(mtx_); // 进行加锁
-        lineCount_++; // 增加日志行数计数器，表示写入了一行日志
-        int n = snprintf(buff_.BeginWrite(), 128, "%d-%02d-%02d %02d:%02d:%02d.%06ld ",
-                    t.tm_year + 1900, t.tm_mon + 1, t.tm_mday,
-                    t.tm_hour, t.tm_min, t.tm_sec, now.tv_usec);// 使用 snprintf 函数将当前时间信息格式化为字符串，并将其写入到日志缓冲区中,返回写入缓冲区的字符数
-                    
-        buff_.HasWritten(n); // 告知日志缓冲区已经写入了 n 个字符
-        AppendLogLevelTitle_(level); // 在日志消息中添加日志级别的标题
-
-        va_start(vaList, format); // 初始化一个va_list对象，它表示了参数列表中可变参数的起始位置
-        int m = vsnprintf(buff_.BeginWrite(), buff_.WritableBytes(), format, vaList); // 根据指定的格式format以及可变参数列表vaList来格式化字符串，并将结果写入到缓冲区中
-        va_end(vaList); // 结束对可变参数列表的访问
-
-        buff_.HasWritten(m);// 告知日志缓冲区已经写入了 m 个字符
-        buff_.Append("\n\0", 2); // 向缓冲区中追加一个字符串
-
-        if(isAsync_ && deque_ && !deque_->full()) { //检查是否启用了异步写日志、日志队列是否可用、以及日志队列是否未满
-            deque_->push_back(buff_.RetrieveAllToStr()); // 将日志缓冲区中的内容转换为字符串，并将其放入日志队列的尾部
-        } else {
-            fputs(buff_.Peek(), fp_); // 直接将日志消息写入到日志文件中
-        }
-        buff_.RetrieveAll(); // 清空日志缓冲区，以便下次写入使用
+    if(isAsync_) {
+        Push_(line, n, level);
+        return;
     }
+    // 同步模式直接写入文件
+    lock_guard<mutex> locker(mtx_);
+    RotateIfNeeded_(CachedLocalTime(now.tv_sec));
+    struct iovec iov = { line, static_cast<size_t>(n) };
+    WriteAll_(&iov, 1);
+    lineCount_++; // 增加日志行数计数器，表示写入了一行日志
+}
+
+// 把一条二进制记录还原成完整的一行文本追加到 textBuff_；调用方需持有 mtx_
+void Log::AppendRecord_(const char* rec, int64_t wallOffset) {
+    LogRecordHeader header;
+    memcpy(&header, rec, sizeof(header));
+    int64_t wall = header.timestamp + wallOffset; // 单调时钟换算成墙上时间
+    time_t tSec = wall / 1000000000;
+    long usec = (wall % 1000000000) / 1000;
+
+    textBuff_.EnsureWriteable(LOG_LINE_LEN);
+    char* line = textBuff_.BeginWrite();
+    int n = FormatTime(line, tSec, usec);
+    n += AppendLogLevelTitle_(line + n, header.level);
+    n += LogRecord::Format(rec, line + n, LOG_LINE_LEN - n - 1);
+    line[n++] = '\n';
+    textBuff_.HasWritten(n);
 }
 
-// 根据给定的日志级别向日志缓冲区中追加对应的日志级别标题
-void Log::AppendLogLevelTitle_(int level) {
+// 根据给定的日志级别向 buf 中写入对应的日志级别标题，返回写入的字节数
+int Log::AppendLogLevelTitle_(char* buf, int level) {
     switch(level) {
     case 0:
-        buff_.Append("[debug]: ", 9);
+        memcpy(buf, "[debug]: ", 9);
         break;
     case 1:
-        buff_.Append("[info] : ", 9);
+        memcpy(buf, "[info] : ", 9);
         break;
     case 2:
-        buff_.Append("[warn] : ", 9);
+        memcpy(buf, "[warn] : ", 9);
         break;
     case 3:
-        buff_.Append("[error]: ", 9);
+        memcpy(buf, "[error]: ", 9);
         break;
     default:
-        buff_.Append("[info] : ", 9);
+        memcpy(buf, "[info] : ", 9);
         break;
     }
+    return 9;
 }
 
-// 刷新日志缓冲区
+// 请求后台线程立即把各线程缓冲区中的日志写入文件
 void Log::flush() {
-    if(isAsync_) { 
-        deque_->flush(); 
+    if(isAsync_) {
+        WakeWriter_();
+    }
+}
+
+// 唤醒后台线程；已经请求过且后台线程还没处理时不重复通知，
+// 通知前短暂获取 condMtx_，保证不会在后台线程检查条件与进入等待之间丢失
+void Log::WakeWriter_() {
+    if(flushRequested_.exchange(true)) { return; }
+    {
+        lock_guard<mutex> locker(condMtx_);
+    }
+    cond_.notify_one();
+}
+
+// 把所有线程缓冲区中当前可读的内容合并成一次 writev 写出，返回写出的字节数；
+// 一批最多写到当前文件的行数上限，剩余部分留到切换文件后的下一批
+size_t Log::WriteRings_(const vector<shared_ptr<LogRing>>& rings) {
+    if(none_of(rings.begin(), rings.end(), [](const shared_ptr<LogRing>& r) { return r->ReadableBytes() > 0; })) {
+        return 0; // 没有待写的日志时不切换文件
+    }
+    const struct tm& t = CachedLocalTime(time(nullptr)); // 每一批只取一次时间来判断是否需要切换文件
+
+    lock_guard<mutex> locker(mtx_);
+    RotateIfNeeded_(t);
+    int budget = nextRotateLine_ - lineCount_; // 当前文件还能写入的行数
+    struct iovec iov[IOV_MAX];
+    vector<size_t> taken(rings.size(), 0);
+    int cnt = 0, lines = 0;
+    size_t total = 0;
+    if(isBinary_) { // 二进制记录先还原成文本，一条记录就是一行
+        total = DecodeRings_(rings, taken.data(), budget, &lines);
+        iov[0].iov_base = const_cast<char*>(textBuff_.Peek());
+        iov[0].iov_len = textBuff_.ReadableBytes();
+        cnt = 1;
+    }
+    for(size_t i = 0; !isBinary_ && i < rings.size() && cnt + 2 <= IOV_MAX && lines < budget; i++) {
+        int segs = rings[i]->Peek(iov + cnt, SIZE_MAX); // 环中只有完整的行
+        for(int j = 0; j < segs && lines < budget; j++) {
+            struct iovec& seg = iov[cnt];
+            const char* p = static_cast<const char*>(seg.iov_base);
+            const char* end = p + seg.iov_len;
+            for(const char* nl = p; (nl = static_cast<const char*>(memchr(nl, '\n', end - nl))) != nullptr; ) {
+                nl++;
+                if(++lines == budget) { // 达到上限，截断在这一行的末尾
+                    seg.iov_len = nl - p;
+                    break;
+                }
+            }
+            taken[i] += seg.iov_len;
+            cnt++;
+        }
+        total += taken[i];
+    }
+    if(total == 0) { return 0; }
+
+    WriteAll_(iov, cnt);
+    ReportDropped_();
+    textBuff_.RetrieveAll();
+    lineCount_ += lines;
+    for(size_t i = 0; i < rings.size(); i++) {
+        if(taken[i]) { rings[i]->Consume(taken[i]); }
+    }
+    if(spaceWaiters_.load() > 0) { // 唤醒按 BLOCK_TIMEOUT 策略等待空间的线程
+        lock_guard<mutex> spaceLocker(spaceMtx_);
+        spaceCond_.notify_all();
     }
-    fflush(fp_); // 刷新文件缓冲区
+    return total;
 }
 
-// 异步写入日志消息到日志文件中
+// 把各线程缓冲区中最多 budget 条二进制记录还原成文本放入 textBuff_，
+// taken 记录每个缓冲区用掉的字节数，返回总字节数；调用方需持有 mtx_
+size_t Log::DecodeRings_(const vector<shared_ptr<LogRing>>& rings, size_t* taken, int budget, int* lines) {
+    int64_t wallOffset = LogRecord::WallOffsetNs(); // 每一批只换算一次时钟
+    size_t total = 0;
+    char tmp[LOG_LINE_LEN];
+    for(size_t i = 0; i < rings.size() && *lines < budget; i++) {
+        struct iovec iov[2];
+        int segs = rings[i]->Peek(iov, SIZE_MAX);
+        size_t avail = 0;
+        for(int j = 0; j < segs; j++) { avail += iov[j].iov_len; }
+        size_t off = 0;
+        while(off < avail && *lines < budget) {
+            uint32_t size = 0;
+            CopyOut(iov, segs, off, reinterpret_cast<char*>(&size), sizeof(size));
+            assert(size >= sizeof(LogRecordHeader) && size <= LOG_LINE_LEN && off + size <= avail);
+            const char* rec = tmp;
+            if(off + size <= iov[0].iov_len) { // 记录连续时直接解码，跨越环尾时先拷贝出来
+                rec = static_cast<const char*>(iov[0].iov_base) + off;
+            } else if(off >= iov[0].iov_len) {
+                rec = static_cast<const char*>(iov[1].iov_base) + (off - iov[0].iov_len);
+            } else {
+                CopyOut(iov, segs, off, tmp, size);
+            }
+            AppendRecord_(rec, wallOffset);
+            off += size;
+            (*lines)++;
+        }
+        taken[i] = off;
+        total += off;
+    }
+    return total;
+}
+
+// 后台线程：按固定周期、积压越过阈值或收到刷新请求时批量写出所有线程缓冲区
 void Log::AsyncWrite_() {
-    string str = "";
-    while(deque_->pop(str)) {
-        lock_guard<mutex> locker(mtx_);
-        fputs(str.c_str(), fp_); // 将字符串str中的内容写入到日志文件中
+    while(true) {
+        {
+            unique_lock<mutex> locker(condMtx_);
+            cond_.wait_for(locker, chrono::milliseconds(FLUSH_INTERVAL_MS), [this] {
+                return isClosing_.load() || flushRequested_.load();
+            });
+        }
+        bool closing = isClosing_.load();
+        flushRequested_ = false;
+        DrainRings_();
+        if(closing) { break; }
+    }
+}
+
+// 写出所有线程缓冲区中的日志直到读空；环形缓冲区只允许一个消费者，由 drainMtx_ 保证
+void Log::DrainRings_() {
+    lock_guard<mutex> drainLocker(drainMtx_);
+    vector<shared_ptr<LogRing>> rings;
+    {
+        lock_guard<mutex> locker(ringMtx_);
+        // 回收所属线程已退出且已读空的缓冲区
+        rings_.erase(remove_if(rings_.begin(), rings_.end(), [](const shared_ptr<LogRing>& r) {
+            return r->IsDetached() && r->ReadableBytes() == 0;
+        }), rings_.end());
+        rings = rings_;
     }
+    while(WriteRings_(rings) > 0) {}
 }
 
 // 获取 Log 类的单例对象
@@ -199,7 +535,7 @@ Log* Log::Instance() {
     return &inst;
 }
 
-// 在一个单独的线程中异步刷新日志
+// 在一个单独的线程中异步写日志
 void Log::FlushLogThread() {
     Log::Instance()->AsyncWrite_();
-}
\ No newline at end of file
+}
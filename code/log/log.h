@@ -2,47 +2,97 @@
  * @Author       : mark
  * @Date         : 2020-06-16
  * @copyleft Apache 2.0
- */ 
+ */
 #ifndef LOG_H
 #define LOG_H
 
 #include <mutex>
 #include <string>
 #include <thread>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <condition_variable>
 #include <sys/time.h>
 #include <string.h>
 #include <stdarg.h>           // vastart va_end
 #include <assert.h>
+#include <errno.h>
+#include <stdint.h>           // SIZE_MAX
+#include <fcntl.h>            // open
+#include <unistd.h>           // write, close
+#include <limits.h>           // IOV_MAX
+#include <sys/uio.h>          // writev
 #include <sys/stat.h>         //mkdir
-#include "blockqueue.h"
+#include "logring.h"
+#include "logrecord.h"
 #include "../buffer/buffer.h"
 
 class Log {
 public:
-    void init(int level, const char* path = "./log", 
+    // 异步模式下本线程缓冲区放不下时的处理策略
+    enum OverflowPolicy {
+        DROP,           // 直接丢弃并计数
+        DROP_LOW_LEVEL, // 积压超过各级别的水位线时先丢弃低级别日志，error 只在缓冲区满时丢弃
+        BLOCK_TIMEOUT,  // 等待后台线程腾出空间，超时后丢弃
+    };
+
+    void init(int level, const char* path = "./log",
                 const char* suffix =".log",
-                int maxQueueCapacity = 1024);
+                int maxQueueCapacity = 1024, bool binary = false);
 
     static Log* Instance();
     static void FlushLogThread();
 
     void write(int level, const char *format,...);
+
+    template<class... Args>
+    void Record(int level, const char* format, const Args&... args);
     void flush();
 
+    void SetOverflowPolicy(OverflowPolicy policy, int blockTimeoutMs = 10);
+    uint64_t GetDropped(int level) const;
+    uint64_t GetDroppedTotal() const;
+    size_t GetQueuedBytes();
+
     int GetLevel();
     void SetLevel(int level);
-    bool IsOpen() { return isOpen_; }
-    
+    bool IsOpen() { return isOpen_.load(std::memory_order_relaxed); }
+    bool IsEnabled(int level) {
+        return isOpen_.load(std::memory_order_relaxed) && level_.load(std::memory_order_relaxed) <= level;
+    }
+
 private:
     Log();
-    void AppendLogLevelTitle_(int level);
+    int AppendLogLevelTitle_(char* buf, int level);
     virtual ~Log();
     void AsyncWrite_();
 
+    LogRing* LocalRing_();
+    bool Push_(const char* data, size_t len, int level);
+    void ReportDropped_();
+    void WakeWriter_();
+    void AppendRecord_(const char* rec, int64_t wallOffset);
+    size_t DecodeRings_(const std::vector<std::shared_ptr<LogRing>>& rings, size_t* taken, int budget, int* lines);
+    void DrainRings_();
+    size_t WriteRings_(const std::vector<std::shared_ptr<LogRing>>& rings);
+    void RotateIfNeeded_(const struct tm& t);
+    void OpenFile_(const char* fileName);
+    void WriteAll_(const struct iovec* iov, int cnt);
+
 private:
     static const int LOG_PATH_LEN = 256;
     static const int LOG_NAME_LEN = 256;
+    static const int LOG_LINE_LEN = 2048; // 单行日志的最大长度，超出部分截断
     static const int MAX_LINES = 50000;
+    static const size_t AVG_LINE_LEN = 128; // 按平均行长把队列容量换算成环形缓冲区字节数
+    static const size_t MIN_RING_SIZE = 64 * 1024;
+    static const size_t FLUSH_BYTES = 64 * 1024; // 积累到这么多字节就立即批量写出
+    static const int FLUSH_INTERVAL_MS = 100; // 否则最多间隔这么久写出一次
+    static const int LEVEL_NUM = 4;
+    static constexpr int LEVEL_WATERMARK[LEVEL_NUM] = { 50, 75, 90, 100 }; // DROP_LOW_LEVEL 下各级别可使用的缓冲区百分比
 
     const char* path_;
     const char* suffix_;
@@ -50,26 +100,73 @@ private:
     int MAX_LINES_;
 
     int lineCount_;
+    int nextRotateLine_; // 行数达到该值时切换到新文件
     int toDay_;
 
-    bool isOpen_;
- 
-    Buffer buff_;
-    int level_;
+    std::atomic<bool> isOpen_;
+
+    std::atomic<int> level_; // 只需要最终可见，使用 relaxed 读写
     bool isAsync_;
+    bool isBinary_; // 二进制延迟格式化模式，只在异步模式下可用
+
+    int fd_; // 当前日志文件，O_APPEND 打开
+    size_t ringSize_; // 新建的线程环形缓冲区容量
+    std::vector<std::shared_ptr<LogRing>> rings_; // 所有写过日志的线程的环形缓冲区
+    std::mutex ringMtx_; // 保护 rings_ 的注册与遍历
+    std::mutex drainMtx_; // 保证同一时刻只有一个线程消费环形缓冲区
+
+    std::atomic<bool> isClosing_; // 通知后台线程退出
+    std::atomic<bool> flushRequested_; // 请求后台线程立即写出（刷新、积压越过阈值或缓冲区放不下）
+    std::mutex condMtx_;
+    std::condition_variable cond_; // 唤醒后台写线程
+
+    std::atomic<OverflowPolicy> policy_;
+    std::atomic<int> blockTimeoutMs_;
+    std::atomic<uint64_t> dropped_[LEVEL_NUM]; // 各级别丢弃的条数
+    uint64_t reportedDrops_; // 已经写入告警的丢弃总数，只由持有 mtx_ 的线程访问
+    std::mutex spaceMtx_;
+    std::condition_variable spaceCond_; // BLOCK_TIMEOUT 策略下等待缓冲区空间
+    std::atomic<int> spaceWaiters_;
+
+    Buffer textBuff_; // 后台线程把二进制记录还原成文本的缓冲区
 
-    FILE* fp_;
-    std::unique_ptr<BlockDeque<std::string>> deque_; 
     std::unique_ptr<std::thread> writeThread_;
-    std::mutex mtx_;
+    std::mutex mtx_; // 保护日志文件的写入与切换
 };
 
+// 二进制模式下只编码格式串地址与原始参数，格式化推迟到后台线程；否则等同于 write()
+template<class... Args>
+void Log::Record(int level, const char* format, const Args&... args) {
+    if(!isBinary_) {
+        write(level, format, args...);
+        return;
+    }
+    size_t size = LogRecord::Size(args...);
+    if(size > static_cast<size_t>(LOG_LINE_LEN)) { // 参数太多放不进一条记录时在本线程格式化
+        write(level, format, args...);
+        return;
+    }
+    char rec[LOG_LINE_LEN];
+    LogRecord::Encode(rec, size, level, format, args...);
+    Push_(rec, size, level);
+}
+
+// 编译期最低日志级别，低于它的日志调用在编译时整体消除（参数表达式也不会求值），
+// 发布构建用 -DLOG_MIN_LEVEL=1 去掉所有 DEBUG 日志
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL 0
+#endif
+
+// 分支预测提示：DEBUG 日志预期关闭，其余级别预期打开
+#define LOG_EXPECT(cond, level) __builtin_expect(!!(cond), (level) > 0)
+
 #define LOG_BASE(level, format, ...) \
     do {\
-        Log* log = Log::Instance();\
-        if (log->IsOpen() && log->GetLevel() <= level) {\
-            log->write(level, format, ##__VA_ARGS__); \
-            log->flush();\
+        if ((level) >= LOG_MIN_LEVEL) {\
+            Log* log = Log::Instance();\
+            if (LOG_EXPECT(log->IsEnabled(level), level)) {\
+                log->Record(level, format, ##__VA_ARGS__); \
+            }\
         }\
     } while(0);
 
@@ -78,4 +175,4 @@ private:
 #define LOG_WARN(format, ...) do {LOG_BASE(2, format, ##__VA_ARGS__)} while(0);
 #define LOG_ERROR(format, ...) do {LOG_BASE(3, format, ##__VA_ARGS__)} while(0);
 
-#endif //LOG_H
\ No newline at end of file
+#endif //LOG_H
@@ -0,0 +1,172 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#include "logrecord.h"
+
+const size_t LogRecord::MAX_STR_ARG;
+
+namespace {
+// 从记录中顺序读取的一个参数
+struct LogArg {
+    uint8_t tag;
+    int64_t i;
+    uint64_t u;
+    double d;
+    const char* s;
+    uint16_t len;
+};
+
+// 读取 p 处的一个参数，返回下一个参数的位置
+const char* ReadArg(const char* p, LogArg& arg) {
+    arg.tag = static_cast<uint8_t>(*p++);
+    switch(arg.tag) {
+    case LogRecord::ARG_INT:
+        memcpy(&arg.i, p, sizeof(arg.i));
+        return p + sizeof(arg.i);
+    case LogRecord::ARG_DOUBLE:
+        memcpy(&arg.d, p, sizeof(arg.d));
+        return p + sizeof(arg.d);
+    case LogRecord::ARG_STR:
+        memcpy(&arg.len, p, sizeof(arg.len));
+        arg.s = p + sizeof(arg.len);
+        return arg.s + arg.len;
+    default: // ARG_UINT, ARG_PTR
+        memcpy(&arg.u, p, sizeof(arg.u));
+        return p + sizeof(arg.u);
+    }
+}
+
+// 按转换说明 spec（已去掉长度修饰符，conv 为转换字符）输出一个参数，类型不匹配时按参数的实际类型输出
+int FormatArg(char* out, size_t outLen, char* spec, size_t specLen, char conv, const LogArg& arg) {
+    char str[LogRecord::MAX_STR_ARG + 1];
+    switch(arg.tag) {
+    case LogRecord::ARG_STR: {
+        size_t len = std::min(static_cast<size_t>(arg.len), LogRecord::MAX_STR_ARG);
+        memcpy(str, arg.s, len);
+        str[len] = '\0';
+        spec[specLen] = 's'; spec[specLen + 1] = '\0';
+        return snprintf(out, outLen, spec, str);
+    }
+    case LogRecord::ARG_DOUBLE:
+        if(strchr("eEfFgGaA", conv)) {
+            spec[specLen] = conv; spec[specLen + 1] = '\0';
+            return snprintf(out, outLen, spec, arg.d);
+        }
+        spec[specLen] = 'g'; spec[specLen + 1] = '\0';
+        return snprintf(out, outLen, spec, arg.d);
+    case LogRecord::ARG_PTR:
+        spec[specLen] = 'p'; spec[specLen + 1] = '\0';
+        return snprintf(out, outLen, spec, reinterpret_cast<void*>(arg.u));
+    default: { // ARG_INT, ARG_UINT
+        long long v = arg.tag == LogRecord::ARG_INT ? arg.i : static_cast<long long>(arg.u);
+        if(conv == 'c') {
+            spec[specLen] = 'c'; spec[specLen + 1] = '\0';
+            return snprintf(out, outLen, spec, static_cast<int>(v));
+        }
+        if(strchr("eEfFgGaA", conv)) {
+            spec[specLen] = conv; spec[specLen + 1] = '\0';
+            return snprintf(out, outLen, spec, static_cast<double>(v));
+        }
+        if(strchr("uoxX", conv) || arg.tag == LogRecord::ARG_UINT) {
+            spec[specLen] = 'l'; spec[specLen + 1] = 'l';
+            spec[specLen + 2] = strchr("uoxX", conv) ? conv : 'u'; spec[specLen + 3] = '\0';
+            return snprintf(out, outLen, spec, static_cast<unsigned long long>(v));
+        }
+        spec[specLen] = 'l'; spec[specLen + 1] = 'l'; spec[specLen + 2] = 'd'; spec[specLen + 3] = '\0';
+        return snprintf(out, outLen, spec, v);
+    }
+    }
+}
+}
+
+// 拷贝一个字符串参数，超过 MAX_STR_ARG 的部分截断
+char* LogRecord::Put_(char* p, const char* s) {
+    if(!s) { s = "(null)"; }
+    uint16_t len = static_cast<uint16_t>(strnlen(s, MAX_STR_ARG));
+    *p++ = ARG_STR;
+    memcpy(p, &len, sizeof(len));
+    memcpy(p + sizeof(len), s, len);
+    return p + sizeof(len) + len;
+}
+
+// 在调用线程格式化好消息，编码成只有一个字符串参数的记录，返回记录字节数；
+// 用于不经过模板的 write() 调用，以及参数过多放不进一条记录的情况
+size_t LogRecord::EncodeText(char* buf, size_t bufLen, int level, const char* format, va_list vaList) {
+    const size_t prefix = sizeof(LogRecordHeader) + 1 + sizeof(uint16_t);
+    assert(bufLen > prefix);
+    size_t room = std::min(bufLen - prefix, static_cast<size_t>(UINT16_MAX));
+    int m = vsnprintf(buf + prefix, room, format, vaList);
+    uint16_t len = m < 0 ? 0 : static_cast<uint16_t>(std::min(static_cast<size_t>(m), room - 1));
+
+    LogRecordHeader header;
+    header.size = static_cast<uint32_t>(prefix + len);
+    header.level = static_cast<uint8_t>(level);
+    header.nargs = 1;
+    header.timestamp = NowNs();
+    header.format = nullptr;
+    memcpy(buf, &header, sizeof(header));
+    buf[sizeof(header)] = ARG_STR;
+    memcpy(buf + sizeof(header) + 1, &len, sizeof(len));
+    return header.size;
+}
+
+// 按格式串把记录中的参数还原成消息文本，写入 out（不含时间与级别），返回写入的字节数；
+// 依次解析 printf 转换说明，长度修饰符按参数的实际宽度重写，不支持 '*' 宽度
+int LogRecord::Format(const char* rec, char* out, int outLen) {
+    assert(outLen > 0);
+    LogRecordHeader header;
+    memcpy(&header, rec, sizeof(header));
+    const char* p = rec + sizeof(header);
+    const char* end = rec + header.size;
+    int n = 0;
+    if(!header.format) { // 已经格式化好的消息
+        LogArg arg;
+        ReadArg(p, arg);
+        n = std::min(static_cast<int>(arg.len), outLen - 1);
+        memcpy(out, arg.s, n);
+        out[n] = '\0';
+        return n;
+    }
+
+    int argsLeft = header.nargs;
+    const char* f = header.format;
+    while(*f && n < outLen - 1) {
+        if(*f != '%') {
+            out[n++] = *f++;
+            continue;
+        }
+        if(f[1] == '%') {
+            out[n++] = '%';
+            f += 2;
+            continue;
+        }
+        const char* start = f++;
+        char spec[32];
+        size_t specLen = 0;
+        spec[specLen++] = '%';
+        bool unsupported = false;
+        while(*f && strchr("-+ #0123456789.*", *f)) { // 标志、宽度与精度原样保留
+            if(*f == '*') { unsupported = true; }
+            if(specLen < sizeof(spec) - 4) { spec[specLen++] = *f; }
+            f++;
+        }
+        while(*f && strchr("hlLqjzt", *f)) { f++; } // 去掉长度修饰符
+        char conv = *f;
+        if(conv) { f++; }
+        if(unsupported || !conv || argsLeft == 0 || p >= end) { // 无法还原的转换说明原样输出
+            int len = std::min(static_cast<int>(f - start), outLen - 1 - n);
+            memcpy(out + n, start, len);
+            n += len;
+            continue;
+        }
+        LogArg arg;
+        p = ReadArg(p, arg);
+        argsLeft--;
+        int m = FormatArg(out + n, outLen - n, spec, specLen, conv, arg);
+        if(m > 0) { n += std::min(m, outLen - 1 - n); }
+    }
+    out[n] = '\0';
+    return n;
+}
@@ -0,0 +1,124 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#ifndef LOGRECORD_H
+#define LOGRECORD_H
+
+#include <stdint.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <assert.h>
+#include <type_traits>
+#include <algorithm>
+
+// 二进制日志记录的记录头，后面依次排列各个参数，每个参数以一个字节的类型标签开头
+struct LogRecordHeader {
+    uint32_t size;      // 整条记录的字节数
+    uint8_t level;      // 日志级别
+    uint8_t nargs;      // 参数个数
+    int64_t timestamp;  // CLOCK_MONOTONIC_COARSE 纳秒时间
+    const char* format; // 格式串地址，作为格式 id；nullptr 表示唯一的字符串参数是已格式化的消息
+};
+
+// 延迟格式化：写日志的线程只把格式串地址、时间戳和原始参数编码成二进制记录，
+// 由后台线程按格式串还原成文本。格式串必须是字符串字面量，字符串参数按值拷贝
+class LogRecord {
+public:
+    enum ArgTag : uint8_t {
+        ARG_INT = 'i',
+        ARG_UINT = 'u',
+        ARG_DOUBLE = 'd',
+        ARG_STR = 's',
+        ARG_PTR = 'p',
+    };
+
+    static const size_t MAX_STR_ARG = 256; // 单个字符串参数最多拷贝的字节数
+
+    template<class... Args>
+    static size_t Size(const Args&... args);
+
+    template<class... Args>
+    static void Encode(char* buf, size_t size, int level, const char* format, const Args&... args);
+
+    static size_t EncodeText(char* buf, size_t bufLen, int level, const char* format, va_list vaList);
+
+    static int Format(const char* rec, char* out, int outLen);
+
+    static int64_t NowNs();
+
+    static int64_t WallOffsetNs();
+
+private:
+    static size_t ArgSize_(const char* s) { return 3 + (s ? strnlen(s, MAX_STR_ARG) : 6); }
+    template<class T>
+    static size_t ArgSize_(const T*) { return 1 + sizeof(uint64_t); }
+    template<class T>
+    static typename std::enable_if<std::is_arithmetic<T>::value || std::is_enum<T>::value, size_t>::type
+    ArgSize_(T) { return 1 + sizeof(uint64_t); }
+
+    static char* Put_(char* p, const char* s);
+    template<class T>
+    static char* Put_(char* p, const T* v) { return PutRaw_(p, ARG_PTR, reinterpret_cast<uint64_t>(v)); }
+    template<class T>
+    static typename std::enable_if<std::is_floating_point<T>::value, char*>::type
+    Put_(char* p, T v) { return PutRaw_(p, ARG_DOUBLE, static_cast<double>(v)); }
+    template<class T>
+    static typename std::enable_if<std::is_enum<T>::value || (std::is_integral<T>::value && std::is_signed<T>::value), char*>::type
+    Put_(char* p, T v) { return PutRaw_(p, ARG_INT, static_cast<int64_t>(v)); }
+    template<class T>
+    static typename std::enable_if<std::is_integral<T>::value && std::is_unsigned<T>::value, char*>::type
+    Put_(char* p, T v) { return PutRaw_(p, ARG_UINT, static_cast<uint64_t>(v)); }
+
+    template<class T>
+    static char* PutRaw_(char* p, ArgTag tag, T v) {
+        *p++ = tag;
+        memcpy(p, &v, sizeof(v));
+        return p + sizeof(v);
+    }
+};
+
+// 计算一条记录编码后的字节数
+template<class... Args>
+size_t LogRecord::Size(const Args&... args) {
+    size_t sizes[] = { sizeof(LogRecordHeader), ArgSize_(args)... };
+    size_t total = 0;
+    for(size_t s : sizes) { total += s; }
+    return total;
+}
+
+// 把记录头和参数编码到 buf 中，size 必须由 Size() 以相同参数算出
+template<class... Args>
+void LogRecord::Encode(char* buf, size_t size, int level, const char* format, const Args&... args) {
+    LogRecordHeader header;
+    header.size = static_cast<uint32_t>(size);
+    header.level = static_cast<uint8_t>(level);
+    header.nargs = static_cast<uint8_t>(sizeof...(args));
+    header.timestamp = NowNs();
+    header.format = format;
+    memcpy(buf, &header, sizeof(header));
+    char* p = buf + sizeof(header);
+    int expand[] = { 0, (p = Put_(p, args), 0)... };
+    (void)expand;
+    (void)p; // 没有参数时 p 只被赋值
+}
+
+// 单调时钟的粗粒度纳秒时间，只有一次 vDSO 调用
+inline int64_t LogRecord::NowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+// 墙上时钟与单调时钟之差，用于把记录中的时间戳换算成本地时间；两个粗粒度时钟在同一时钟中断更新
+inline int64_t LogRecord::WallOffsetNs() {
+    struct timespec real, mono;
+    clock_gettime(CLOCK_REALTIME_COARSE, &real);
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &mono);
+    return (static_cast<int64_t>(real.tv_sec) - mono.tv_sec) * 1000000000 + (real.tv_nsec - mono.tv_nsec);
+}
+
+#endif // LOGRECORD_H
@@ -0,0 +1,113 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#ifndef LOGRING_H
+#define LOGRING_H
+
+#include <atomic>
+#include <memory>
+#include <cstring>
+#include <algorithm>
+#include <sys/uio.h>
+#include <assert.h>
+
+// 单生产者单消费者的字节环形缓冲区：生产者是写日志的线程，消费者是后台写线程，双方都不加锁
+class LogRing {
+public:
+    explicit LogRing(size_t capacity);
+
+    ~LogRing() = default;
+
+    bool TryPush(const char* data, size_t len);
+
+    bool Fits(size_t len, size_t limit);
+
+    size_t ProducerReadable() const { return head_.load(std::memory_order_relaxed) - tailCache_; }
+
+    int Peek(struct iovec* iov, size_t maxLen) const;
+
+    void Consume(size_t len);
+
+    size_t ReadableBytes() const;
+
+    size_t Capacity() const { return cap_; }
+
+    void Detach() { detached_.store(true, std::memory_order_release); }
+
+    bool IsDetached() const { return detached_.load(std::memory_order_acquire); }
+
+private:
+    std::unique_ptr<char[]> buf_; // 环形存储区
+    size_t cap_; // 容量，2 的幂
+    size_t mask_; // cap_ - 1
+
+    alignas(64) std::atomic<size_t> head_; // 写入位置，只由生产者推进
+    size_t tailCache_; // 生产者缓存的读取位置，空间看起来不够时才重新读取 tail_，减少与消费者之间的缓存行争用
+    alignas(64) std::atomic<size_t> tail_; // 读取位置，只由消费者推进
+    std::atomic<bool> detached_; // 所属线程已退出，读空后可回收
+};
+
+// 构造函数，容量向上取整为 2 的幂
+inline LogRing::LogRing(size_t capacity) : head_(0), tailCache_(0), tail_(0), detached_(false) {
+    assert(capacity > 0);
+    cap_ = 1;
+    while(cap_ < capacity) { cap_ <<= 1; }
+    mask_ = cap_ - 1;
+    buf_.reset(new char[cap_]);
+}
+
+// 生产者判断再写入 len 字节后积压是否不超过 limit，按缓存的读取位置判断失败时才重新读取 tail_
+inline bool LogRing::Fits(size_t len, size_t limit) {
+    size_t head = head_.load(std::memory_order_relaxed);
+    if(head - tailCache_ + len <= limit) {
+        return true;
+    }
+    tailCache_ = tail_.load(std::memory_order_acquire);
+    return head - tailCache_ + len <= limit;
+}
+
+// 生产者写入一条完整记录，空间不足时整条放弃并返回 false
+inline bool LogRing::TryPush(const char* data, size_t len) {
+    if(!Fits(len, cap_)) {
+        return false;
+    }
+    size_t head = head_.load(std::memory_order_relaxed);
+    size_t off = head & mask_;
+    size_t first = std::min(len, cap_ - off); // 到环尾为止能写入的部分
+    memcpy(buf_.get() + off, data, first);
+    memcpy(buf_.get(), data + first, len - first);
+    head_.store(head + len, std::memory_order_release);
+    return true;
+}
+
+// 消费者获取最多 maxLen 字节的可读区域，环绕时拆成两段，返回段数
+inline int LogRing::Peek(struct iovec* iov, size_t maxLen) const {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    size_t head = head_.load(std::memory_order_acquire);
+    size_t len = std::min(head - tail, maxLen);
+    if(len == 0) { return 0; }
+    size_t off = tail & mask_;
+    size_t first = std::min(len, cap_ - off);
+    iov[0].iov_base = buf_.get() + off;
+    iov[0].iov_len = first;
+    if(first == len) { return 1; }
+    iov[1].iov_base = buf_.get();
+    iov[1].iov_len = len - first;
+    return 2;
+}
+
+// 消费者释放已经写出的 len 字节
+inline void LogRing::Consume(size_t len) {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    assert(len <= head_.load(std::memory_order_acquire) - tail);
+    tail_.store(tail + len, std::memory_order_release);
+}
+
+// 当前未被消费的字节数
+inline size_t LogRing::ReadableBytes() const {
+    return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+}
+
+#endif // LOGRING_H
@@ -4,16 +4,66 @@
  * @copyleft Apache 2.0
  */
 #include <unistd.h>
+#include <stdio.h>
 #include "server/webserver.h"
 
 // test
-int main() {
+int main(int argc, char *argv[]) {
     /* 守护进程 后台运行 */
     //daemon(1, 0);
     //192.168.142.129
+    const char *confPath = argc > 1 ? argv[1] : "./server.conf"; // 配置文件，不存在时使用下面的默认值
+    int port = 1316, trigMode = 3, timeoutMS = 60000;   /* 端口 ET模式 timeoutMs */
+    bool optLinger = false;                             /* 优雅退出 */
+    int sqlPort = 3306;                                 /* Mysql配置,刚开始连接时需要更改账号、密码、数据库 */
+    std::string sqlUser = "root", sqlPwd = "root", dbName = "webserver";
+    int connPoolNum = 12, threadNum = 6;                /* 连接池数量 线程池数量 */
+    int connPoolMin = 0, sqlWaitMs = 1000;              /* 最小连接数（0 与连接池数量相同） 取连接的最长等待毫秒数 */
+    int hashThreads = 2;                                /* 密码哈希线程数 */
+    bool openLog = true;                                /* 日志开关 */
+    int logLevel = 1, logQueSize = 1024;                /* 日志等级 日志异步队列容量 */
+    std::string logPolicy = "drop_low_level";           /* 日志缓冲区满时的策略：drop / drop_low_level / block */
+    int logBlockMs = 10;                                /* block 策略的最长等待毫秒数 */
+    int traceSample = 0, adminPort = 0;                 /* 请求追踪采样间隔（0 只统计分阶段耗时） 管理端口（0 不开启） */
+    std::string authStore = "mysql", authFile = "./users.db"; /* 用户存储：mysql 或 local（本地文件，不连接数据库） */
+    int sessionTtl = 1800;                              /* 会话有效期（秒），0 不签发会话 */
+    std::string sessionFile;                            /* 会话文件，为空时会话只保存在内存中 */
+
+    Config conf;
+    std::string err;
+    if (conf.Load(confPath, &err)) {
+        bool valid = conf.ReadInt("port", &port) && conf.ReadInt("trig_mode", &trigMode)
+            && conf.ReadInt("timeout_ms", &timeoutMS) && conf.ReadBool("opt_linger", &optLinger)
+            && conf.ReadInt("sql_port", &sqlPort) && conf.ReadString("sql_user", &sqlUser)
+            && conf.ReadString("sql_pwd", &sqlPwd) && conf.ReadString("db_name", &dbName)
+            && conf.ReadInt("conn_pool_num", &connPoolNum) && conf.ReadInt("thread_num", &threadNum)
+            && conf.ReadInt("conn_pool_min", &connPoolMin) && conf.ReadInt("sql_wait_ms", &sqlWaitMs)
+            && conf.ReadBool("open_log", &openLog) && conf.ReadInt("log_level", &logLevel)
+            && conf.ReadInt("log_queue_size", &logQueSize) && conf.ReadInt("trace_sample", &traceSample)
+            && conf.ReadString("log_overflow_policy", &logPolicy) && conf.ReadInt("log_block_timeout_ms", &logBlockMs)
+            && conf.ReadInt("admin_port", &adminPort) && conf.ReadString("auth_store", &authStore)
+            && conf.ReadString("auth_file", &authFile) && conf.ReadInt("hash_threads", &hashThreads)
+            && conf.ReadInt("session_ttl_s", &sessionTtl) && conf.ReadString("session_file", &sessionFile)
+            && sessionTtl >= 0 && (authStore == "mysql" || authStore == "local") && logBlockMs >= 0
+            && (logPolicy.empty() || logPolicy == "drop" || logPolicy == "drop_low_level" || logPolicy == "block");
+        if (!valid) {
+            fprintf(stderr, "invalid value in %s\n", confPath);
+            return 1;
+        }
+    } else if (argc > 1) { // 显式指定的配置文件必须存在
+        fprintf(stderr, "%s\n", err.c_str());
+        return 1;
+    }
+
+    Log::Instance()->SetOverflowPolicy(logPolicy == "drop" ? Log::DROP :
+                                       logPolicy == "block" ? Log::BLOCK_TIMEOUT : Log::DROP_LOW_LEVEL,
+                                       logBlockMs); // 在服务器初始化日志之前设置，SIGHUP 时再按配置文件更新
     WebServer server(
-            1316, 3, 60000, false,             /* 端口 ET模式 timeoutMs 优雅退出  */
-            3306, "root", "root", "webserver", /* Mysql配置,刚开始连接时需要更改账号、密码、数据库 */
-            12, 6, true, 1, 1024);             /* 连接池数量 线程池数量 日志开关 日志等级 日志异步队列容量 */
+            port, trigMode, timeoutMS, optLinger,
+            sqlPort, sqlUser.c_str(), sqlPwd.c_str(), dbName.c_str(),
+            connPoolNum, threadNum, openLog, logLevel, logQueSize,
+            traceSample, adminPort, authStore == "local" ? authFile.c_str() : "",
+            connPoolMin, sqlWaitMs, hashThreads, sessionTtl, sessionFile.c_str());
+    server.EnableReload(confPath); // kill -HUP 重新加载可在运行中修改的配置项
     server.Start();
-}
\ No newline at end of file
+}
@@ -0,0 +1,286 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#include "metrics.h"
+
+using namespace std;
+
+namespace {
+atomic<int> nextShard(0);
+
+// 追加一行 name{labels} value
+void AppendSample(string& out, const string& name, const char* suffix,
+                  const string& labels, const char* extraLabel, const char* value) {
+    out += name;
+    out += suffix;
+    if(!labels.empty() || extraLabel) {
+        out += '{';
+        out += labels;
+        if(extraLabel) {
+            if(!labels.empty()) { out += ','; }
+            out += extraLabel;
+        }
+        out += '}';
+    }
+    out += ' ';
+    out += value;
+    out += '\n';
+}
+}
+
+// 构造函数
+Counter::Counter() {
+    for(auto& s : shards_) { s.value.store(0, memory_order_relaxed); }
+}
+
+// 当前线程的分片序号，线程首次使用时轮流分配
+int Counter::ShardIndex() {
+    static thread_local int idx = nextShard.fetch_add(1, memory_order_relaxed) % METRIC_SHARDS;
+    return idx;
+}
+
+// 各分片之和
+uint64_t Counter::Value() const {
+    uint64_t total = 0;
+    for(const auto& s : shards_) { total += s.value.load(memory_order_relaxed); }
+    return total;
+}
+
+// 构造函数
+Histogram::Histogram() : shards_(new Shard[METRIC_SHARDS]) {
+    for(int i = 0; i < METRIC_SHARDS; i++) {
+        for(auto& c : shards_[i].counts) { c.store(0, memory_order_relaxed); }
+        shards_[i].sum.store(0, memory_order_relaxed);
+        shards_[i].count.store(0, memory_order_relaxed);
+    }
+}
+
+// 值所在的桶：小于 SUB_BUCKETS 的值各占一桶，之后由最高位确定区间、次高的 SUB_BITS 位确定子桶
+int Histogram::BucketIndex(uint64_t v) {
+    if(v < static_cast<uint64_t>(SUB_BUCKETS)) { return static_cast<int>(v); }
+    int msb = 63 - __builtin_clzll(v);
+    if(msb > MAX_BITS) { return BUCKETS - 1; }
+    int sub = static_cast<int>((v >> (msb - SUB_BITS)) & (SUB_BUCKETS - 1));
+    return min((msb - SUB_BITS + 1) * SUB_BUCKETS + sub, BUCKETS - 1);
+}
+
+// 桶的下界（含），是 BucketIndex 的逆
+uint64_t Histogram::BucketLower(int idx) {
+    if(idx < SUB_BUCKETS) { return static_cast<uint64_t>(idx); }
+    int msb = idx / SUB_BUCKETS + SUB_BITS - 1;
+    int sub = idx % SUB_BUCKETS;
+    return static_cast<uint64_t>(SUB_BUCKETS + sub) << (msb - SUB_BITS);
+}
+
+// 记录一个值
+void Histogram::Record(uint64_t v) {
+    Shard& s = shards_[Counter::ShardIndex()];
+    s.counts[BucketIndex(v)].fetch_add(1, memory_order_relaxed);
+    s.sum.fetch_add(v, memory_order_relaxed);
+    s.count.fetch_add(1, memory_order_relaxed);
+}
+
+// 记录总数
+uint64_t Histogram::Count() const {
+    uint64_t total = 0;
+    for(int i = 0; i < METRIC_SHARDS; i++) { total += shards_[i].count.load(memory_order_relaxed); }
+    return total;
+}
+
+// 记录值之和
+uint64_t Histogram::Sum() const {
+    uint64_t total = 0;
+    for(int i = 0; i < METRIC_SHARDS; i++) { total += shards_[i].sum.load(memory_order_relaxed); }
+    return total;
+}
+
+// 合并各分片得到每个桶的计数
+void Histogram::Snapshot(vector<uint64_t>& counts) const {
+    counts.assign(BUCKETS, 0);
+    for(int i = 0; i < METRIC_SHARDS; i++) {
+        for(int b = 0; b < BUCKETS; b++) {
+            counts[b] += shards_[i].counts[b].load(memory_order_relaxed);
+        }
+    }
+}
+
+// 分位数（q 取 0~1），返回所在桶的下界，没有记录时返回 0
+uint64_t Histogram::Percentile(double q) const {
+    vector<uint64_t> counts;
+    Snapshot(counts);
+    uint64_t total = 0;
+    for(uint64_t c : counts) { total += c; }
+    if(total == 0) { return 0; }
+    uint64_t rank = static_cast<uint64_t>(q * total);
+    if(rank >= total) { rank = total - 1; }
+    uint64_t seen = 0;
+    for(int b = 0; b < BUCKETS; b++) {
+        seen += counts[b];
+        if(seen > rank) { return BucketLower(b); }
+    }
+    return BucketLower(BUCKETS - 1);
+}
+
+// 获取单例
+MetricsRegistry* MetricsRegistry::Instance() {
+    static MetricsRegistry inst;
+    return &inst;
+}
+
+// 按名称与标签查找已登记的指标，调用方持有 mtx_
+MetricsRegistry::Entry* MetricsRegistry::Find_(const string& name, const string& labels) {
+    for(auto& e : entries_) {
+        if(e->name == name && e->labels == labels) { return e.get(); }
+    }
+    return nullptr;
+}
+
+// 登记一个新指标，调用方持有 mtx_
+MetricsRegistry::Entry* MetricsRegistry::Add_(const string& name, const string& help,
+                                              const string& labels, MetricType type) {
+    unique_ptr<Entry> e(new Entry);
+    e->name = name;
+    e->help = help;
+    e->labels = labels;
+    e->type = type;
+    e->scale = 1;
+    entries_.push_back(move(e));
+    return entries_.back().get();
+}
+
+// 获取计数器，不存在时登记
+Counter* MetricsRegistry::GetCounter(const string& name, const string& help, const string& labels) {
+    lock_guard<mutex> locker(mtx_);
+    Entry* e = Find_(name, labels);
+    if(!e) {
+        e = Add_(name, help, labels, COUNTER);
+        e->counter.reset(new Counter);
+    }
+    assert(e->type == COUNTER);
+    return e->counter.get();
+}
+
+// 获取瞬时值，不存在时登记
+Gauge* MetricsRegistry::GetGauge(const string& name, const string& help, const string& labels) {
+    lock_guard<mutex> locker(mtx_);
+    Entry* e = Find_(name, labels);
+    if(!e) {
+        e = Add_(name, help, labels, GAUGE);
+        e->gauge.reset(new Gauge);
+    }
+    assert(e->type == GAUGE);
+    return e->gauge.get();
+}
+
+// 获取直方图，不存在时登记；scale 为输出时乘上的单位换算
+Histogram* MetricsRegistry::GetHistogram(const string& name, const string& help, const string& labels, double scale) {
+    lock_guard<mutex> locker(mtx_);
+    Entry* e = Find_(name, labels);
+    if(!e) {
+        e = Add_(name, help, labels, HISTOGRAM);
+        e->histogram.reset(new Histogram);
+        e->scale = scale;
+    }
+    assert(e->type == HISTOGRAM);
+    return e->histogram.get();
+}
+
+// 登记在抓取时求值的指标，用于已由其他模块维护的数值（连接数、队列长度等）；同名同标签时替换
+void MetricsRegistry::AddCallback(const string& name, const string& help, const string& labels,
+                                  bool isCounter, function<double()> fn) {
+    lock_guard<mutex> locker(mtx_);
+    Entry* e = Find_(name, labels);
+    if(!e) {
+        e = Add_(name, help, labels, isCounter ? CALLBACK_COUNTER : CALLBACK_GAUGE);
+    }
+    assert(e->type == CALLBACK_COUNTER || e->type == CALLBACK_GAUGE);
+    e->fn = move(fn);
+}
+
+// 注销回调型指标，回调捕获的对象析构前调用；计数器等对象的指针可能仍被持有，不会释放
+void MetricsRegistry::Remove(const string& name, const string& labels) {
+    lock_guard<mutex> locker(mtx_);
+    for(auto it = entries_.begin(); it != entries_.end(); ++it) {
+        Entry& e = **it;
+        if(e.name == name && e.labels == labels && (e.type == CALLBACK_COUNTER || e.type == CALLBACK_GAUGE)) {
+            entries_.erase(it);
+            return;
+        }
+    }
+}
+
+// Prometheus 中的类型名
+const char* MetricsRegistry::TypeName_(MetricType type) {
+    switch(type) {
+    case COUNTER:
+    case CALLBACK_COUNTER:
+        return "counter";
+    case HISTOGRAM:
+        return "histogram";
+    default:
+        return "gauge";
+    }
+}
+
+// 输出直方图：以 2 的幂为 le 边界的累计计数，以及 _sum 与 _count。
+// le 是含边界的，2^k 所在的桶计入 le="2^k"；该桶宽度不超过 2^k 的 1/4，其中略大于 2^k 的值也会计入
+void MetricsRegistry::RenderHistogram_(string& out, const Entry& e) {
+    vector<uint64_t> counts;
+    e.histogram->Snapshot(counts);
+    char value[32];
+    char le[48];
+    uint64_t cumulative = 0;
+    int b = 0;
+    for(int k = 0; k <= Histogram::MAX_BITS; k++) {
+        int last = Histogram::BucketIndex(1ULL << k);
+        for(; b <= last; b++) { cumulative += counts[b]; }
+        snprintf(le, sizeof(le), "le=\"%g\"", static_cast<double>(1ULL << k) * e.scale);
+        snprintf(value, sizeof(value), "%llu", static_cast<unsigned long long>(cumulative));
+        AppendSample(out, e.name, "_bucket", e.labels, le, value);
+    }
+    for(; b < Histogram::BUCKETS; b++) { cumulative += counts[b]; }
+    snprintf(value, sizeof(value), "%llu", static_cast<unsigned long long>(cumulative));
+    AppendSample(out, e.name, "_bucket", e.labels, "le=\"+Inf\"", value);
+    snprintf(value, sizeof(value), "%g", static_cast<double>(e.histogram->Sum()) * e.scale);
+    AppendSample(out, e.name, "_sum", e.labels, nullptr, value);
+    snprintf(value, sizeof(value), "%llu", static_cast<unsigned long long>(cumulative));
+    AppendSample(out, e.name, "_count", e.labels, nullptr, value);
+}
+
+// 以 Prometheus 文本格式输出全部指标，同名指标归为一组，只输出一次 HELP 与 TYPE
+string MetricsRegistry::Render() {
+    lock_guard<mutex> locker(mtx_);
+    string out;
+    out.reserve(8192);
+    vector<bool> done(entries_.size(), false);
+    char value[32];
+    for(size_t i = 0; i < entries_.size(); i++) {
+        if(done[i]) { continue; }
+        const Entry& head = *entries_[i];
+        out += "# HELP " + head.name + " " + head.help + "\n";
+        out += "# TYPE " + head.name + " " + TypeName_(head.type) + "\n";
+        for(size_t j = i; j < entries_.size(); j++) {
+            const Entry& e = *entries_[j];
+            if(done[j] || e.name != head.name) { continue; }
+            done[j] = true;
+            switch(e.type) {
+            case COUNTER:
+                snprintf(value, sizeof(value), "%llu", static_cast<unsigned long long>(e.counter->Value()));
+                break;
+            case GAUGE:
+                snprintf(value, sizeof(value), "%lld", static_cast<long long>(e.gauge->Value()));
+                break;
+            case HISTOGRAM:
+                RenderHistogram_(out, e);
+                continue;
+            default:
+                snprintf(value, sizeof(value), "%.17g", e.fn ? e.fn() : 0.0);
+                break;
+            }
+            AppendSample(out, e.name, "", e.labels, nullptr, value);
+        }
+    }
+    return out;
+}
@@ -0,0 +1,144 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <mutex>
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <functional>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#include <assert.h>
+
+// 计数器与直方图的分片数：每个线程固定落到一个分片，线程数不超过分片数时递增互不争用
+static const int METRIC_SHARDS = 16;
+
+// 单调递增的计数器，按线程分片，每个分片独占一个缓存行
+class Counter {
+public:
+    Counter();
+
+    void Inc(uint64_t n = 1) { shards_[ShardIndex()].value.fetch_add(n, std::memory_order_relaxed); }
+
+    uint64_t Value() const;
+
+    static int ShardIndex();
+
+private:
+    struct Shard {
+        std::atomic<uint64_t> value;
+        char pad[64 - sizeof(std::atomic<uint64_t>)];
+    };
+    Shard shards_[METRIC_SHARDS];
+};
+
+// 可增可减的瞬时值
+class Gauge {
+public:
+    Gauge() : value_(0) {}
+
+    void Set(int64_t v) { value_.store(v, std::memory_order_relaxed); }
+
+    void Add(int64_t n) { value_.fetch_add(n, std::memory_order_relaxed); }
+
+    int64_t Value() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<int64_t> value_;
+};
+
+// 对数线性直方图（HDR 风格）：每个 2 的幂区间再等分为 SUB_BUCKETS 份，相对误差不超过 25%；
+// 记录一次只是一次分片内的原子加，不加锁
+class Histogram {
+public:
+    static const int SUB_BITS = 2;
+    static const int SUB_BUCKETS = 1 << SUB_BITS;
+    static const int MAX_BITS = 32; // 超过 2^32 的值计入最后一个桶
+    static const int BUCKETS = (MAX_BITS - SUB_BITS + 2) * SUB_BUCKETS;
+
+    Histogram();
+
+    void Record(uint64_t v);
+
+    uint64_t Count() const;
+
+    uint64_t Sum() const;
+
+    uint64_t Percentile(double q) const;
+
+    void Snapshot(std::vector<uint64_t>& counts) const;
+
+    static int BucketIndex(uint64_t v);
+
+    static uint64_t BucketLower(int idx);
+
+private:
+    struct Shard {
+        std::atomic<uint64_t> counts[BUCKETS];
+        std::atomic<uint64_t> sum;
+        std::atomic<uint64_t> count;
+    };
+    std::unique_ptr<Shard[]> shards_;
+};
+
+// 指标注册表：按名称与标签登记指标，Render() 输出 Prometheus 文本格式。
+// 登记只在启动或首次使用时加锁，返回的指针在进程内一直有效，热路径上只做原子操作
+class MetricsRegistry {
+public:
+    static MetricsRegistry* Instance();
+
+    Counter* GetCounter(const std::string& name, const std::string& help, const std::string& labels = "");
+
+    Gauge* GetGauge(const std::string& name, const std::string& help, const std::string& labels = "");
+
+    Histogram* GetHistogram(const std::string& name, const std::string& help,
+                            const std::string& labels = "", double scale = 1e-6);
+
+    void AddCallback(const std::string& name, const std::string& help, const std::string& labels,
+                     bool isCounter, std::function<double()> fn);
+
+    void Remove(const std::string& name, const std::string& labels = "");
+
+    std::string Render();
+
+private:
+    MetricsRegistry() = default;
+
+    enum MetricType { COUNTER, GAUGE, HISTOGRAM, CALLBACK_COUNTER, CALLBACK_GAUGE };
+
+    struct Entry {
+        std::string name;
+        std::string help;
+        std::string labels; // 形如 code="200"，不含花括号
+        MetricType type;
+        std::unique_ptr<Counter> counter;
+        std::unique_ptr<Gauge> gauge;
+        std::unique_ptr<Histogram> histogram;
+        double scale; // 直方图的单位换算，记录微秒、输出秒时为 1e-6
+        std::function<double()> fn; // 回调型指标在抓取时求值
+    };
+
+    Entry* Find_(const std::string& name, const std::string& labels);
+    Entry* Add_(const std::string& name, const std::string& help, const std::string& labels, MetricType type);
+    static const char* TypeName_(MetricType type);
+    static void RenderHistogram_(std::string& out, const Entry& e);
+
+    std::vector<std::unique_ptr<Entry>> entries_;
+    std::mutex mtx_;
+};
+
+// 单调时钟的微秒时间，用于计算耗时
+inline int64_t MetricsNowUs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+#endif //METRICS_H
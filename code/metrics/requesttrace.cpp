@@ -0,0 +1,121 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#include "requesttrace.h"
+
+using namespace std;
+
+const char* RequestTracer::PHASE_NAME[PHASE_NUM] = {
+    "queue", "read", "parse", "db_queue", "verify", "handler", "write_wait", "write", "total"
+};
+
+// 构造函数：登记各阶段的直方图
+RequestTracer::RequestTracer() : sampleEvery_(0), fd_(-1) {
+    MetricsRegistry* reg = MetricsRegistry::Instance();
+    for(int i = 0; i < PHASE_NUM; i++) {
+        hist_[i] = reg->GetHistogram("webserver_request_phase_seconds", "Request latency by phase.",
+                                     string("phase=\"") + PHASE_NAME[i] + "\"");
+    }
+}
+
+// 析构函数
+RequestTracer::~RequestTracer() {
+    Close();
+}
+
+// 获取单例
+RequestTracer* RequestTracer::Instance() {
+    static RequestTracer inst;
+    return &inst;
+}
+
+// 开启采样：每 sampleEvery 个完成的请求写出一个到 file，sampleEvery 为 0 时只统计直方图
+void RequestTracer::Init(const char* file, int sampleEvery) {
+    assert(file && sampleEvery >= 0);
+    Close();
+    if(sampleEvery == 0) { return; }
+    lock_guard<mutex> locker(mtx_);
+    fd_ = open(file, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+    if(fd_ < 0) { return; }
+    ssize_t n = ::write(fd_, "[\n", 2); // JSON 数组格式，结尾的 ] 可以省略，进程异常退出时文件仍可打开
+    (void)n;
+    sampleEvery_.store(sampleEvery, memory_order_relaxed);
+}
+
+// 停止采样并关闭文件
+void RequestTracer::Close() {
+    sampleEvery_.store(0, memory_order_relaxed);
+    lock_guard<mutex> locker(mtx_);
+    if(fd_ >= 0) {
+        close(fd_);
+        fd_ = -1;
+    }
+}
+
+// 请求的最后一个字节写出后调用：计算各阶段耗时计入直方图，必要时写出采样
+void RequestTracer::Finish(const RequestTrace& t, int fd, const char* path, int status) {
+    if(t.parseStart == 0 || t.lastByte == 0) { return; } // 没有完整经历一次请求
+    bool db = t.dbStart > 0; // 没有访问数据库的请求不计 DB_QUEUE 与 VERIFY
+    int64_t starts[PHASE_NUM] = {
+        t.enqueue, t.dequeue, t.parseStart, db ? t.parseDone : 0, t.dbStart,
+        db ? t.dbDone : t.parseDone, t.handlerDone, t.firstByte, t.enqueue
+    };
+    int64_t ends[PHASE_NUM] = {
+        t.dequeue, t.parseStart, t.parseDone, t.dbStart, t.dbDone,
+        t.handlerDone, t.firstByte, t.lastByte, t.lastByte
+    };
+    int64_t durations[PHASE_NUM];
+    for(int i = 0; i < PHASE_NUM; i++) {
+        durations[i] = (starts[i] > 0 && ends[i] >= starts[i]) ? ends[i] - starts[i] : -1;
+    }
+    for(int i = 0; i < PHASE_NUM; i++) {
+        if(durations[i] >= 0) { hist_[i]->Record(durations[i]); }
+    }
+
+    int every = sampleEvery_.load(memory_order_relaxed);
+    if(every > 0) {
+        static thread_local uint64_t finished = 0; // 各线程各自计数，不共享缓存行
+        if(++finished % every == 0) { WriteSample_(starts, durations, fd, path, status); }
+    }
+}
+
+// 把一个请求写成一组 Chrome trace 的完整事件（ph 为 X），每个连接一行
+void RequestTracer::WriteSample_(const int64_t* starts, const int64_t* durations,
+                                 int fd, const char* path, int status) {
+    char escaped[256];
+    size_t n = 0;
+    for(const char* p = path; *p && n < sizeof(escaped) - 2; p++) { // 转义引号与反斜杠，丢弃控制字符
+        if(*p == '"' || *p == '\\') { escaped[n++] = '\\'; }
+        if(static_cast<unsigned char>(*p) >= 0x20) { escaped[n++] = *p; }
+    }
+    escaped[n] = '\0';
+
+    string out;
+    char line[512];
+    int pid = getpid();
+    for(int i = 0; i < PHASE_NUM; i++) {
+        if(durations[i] < 0) { continue; }
+        int64_t start = starts[i];
+        int64_t dur = durations[i];
+        int len;
+        if(i == TOTAL) {
+            len = snprintf(line, sizeof(line),
+                "{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%lld,\"dur\":%lld,\"pid\":%d,\"tid\":%d,"
+                "\"args\":{\"path\":\"%s\",\"status\":%d}},\n",
+                PHASE_NAME[i], static_cast<long long>(start), static_cast<long long>(dur),
+                pid, fd, escaped, status);
+        } else {
+            len = snprintf(line, sizeof(line),
+                "{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%lld,\"dur\":%lld,\"pid\":%d,\"tid\":%d},\n",
+                PHASE_NAME[i], static_cast<long long>(start), static_cast<long long>(dur), pid, fd);
+        }
+        out.append(line, min(len, static_cast<int>(sizeof(line)) - 1));
+    }
+    lock_guard<mutex> locker(mtx_);
+    if(fd_ >= 0) { // 一个请求的事件一次写出，进程被杀时文件中不会留下半行
+        ssize_t n = ::write(fd_, out.data(), out.size());
+        (void)n;
+    }
+}
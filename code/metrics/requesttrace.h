@@ -0,0 +1,73 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#ifndef REQUESTTRACE_H
+#define REQUESTTRACE_H
+
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <stdio.h>
+#include <fcntl.h>      // open
+#include <unistd.h>     // getpid, write, close
+#include "metrics.h"
+
+// 一个请求在各阶段的时间点（单调时钟微秒），0 表示该阶段尚未发生
+struct RequestTrace {
+    int64_t enqueue;     // 主线程把读事件交给线程池
+    int64_t dequeue;     // 工作线程开始处理读事件
+    int64_t parseStart;  // 读完数据，开始解析
+    int64_t parseDone;   // 解析完成
+    int64_t dbStart;     // 数据库线程开始校验（只有登录注册请求）
+    int64_t dbDone;      // 数据库校验完成
+    int64_t handlerDone; // 响应已生成
+    int64_t firstByte;   // 响应的第一个字节写出
+    int64_t lastByte;    // 响应的最后一个字节写出
+
+    void Reset() {
+        enqueue = dequeue = parseStart = parseDone = dbStart = dbDone = handlerDone = firstByte = lastByte = 0;
+    }
+};
+
+// 请求分阶段耗时：每个完成的请求把各阶段耗时计入直方图，
+// 并可每 N 个请求采样一个，以 Chrome trace-event 格式写入文件（chrome://tracing 或 Perfetto 打开）
+class RequestTracer {
+public:
+    enum Phase {
+        QUEUE,      // 线程池排队
+        READ,       // 读 socket
+        PARSE,      // 解析
+        DB_QUEUE,   // 在数据库执行器中排队
+        VERIFY,     // 数据库校验
+        HANDLER,    // 生成响应，登录注册请求从校验完成算起，含交回事件循环的时间
+        WRITE_WAIT, // 生成响应到写出第一个字节，含等待可写事件与再次排队
+        WRITE,      // 第一个字节到最后一个字节
+        TOTAL,      // 入队到最后一个字节
+        PHASE_NUM,
+    };
+
+    static RequestTracer* Instance();
+
+    void Init(const char* file, int sampleEvery);
+
+    void Close();
+
+    void Finish(const RequestTrace& trace, int fd, const char* path, int status);
+
+private:
+    RequestTracer();
+    ~RequestTracer();
+
+    void WriteSample_(const int64_t* starts, const int64_t* durations, int fd, const char* path, int status);
+
+    static const char* PHASE_NAME[PHASE_NUM];
+
+    Histogram* hist_[PHASE_NUM];
+    std::atomic<int> sampleEvery_; // 0 表示不采样
+    std::mutex mtx_; // 保护 fd_
+    int fd_; // 采样输出的文件
+};
+
+#endif //REQUESTTRACE_H
@@ -0,0 +1,75 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#include "cpuexecutor.h"
+
+using namespace std;
+
+// name 用作指标的 executor 标签
+CpuExecutor::CpuExecutor(const string& name, size_t threadCount, size_t maxQueue, int maxWaitMs)
+    : maxQueue_(maxQueue), maxWaitUs_(static_cast<int64_t>(maxWaitMs) * 1000), isClosed_(false) {
+    assert(threadCount > 0 && maxQueue > 0 && maxWaitMs > 0);
+    MetricsRegistry* reg = MetricsRegistry::Instance();
+    string label = "executor=\"" + name + "\"";
+    rejected_ = reg->GetCounter("webserver_cpu_tasks_rejected_total", "CPU tasks rejected because the queue was full.", label);
+    expired_ = reg->GetCounter("webserver_cpu_tasks_expired_total", "CPU tasks dropped after waiting too long in the queue.", label);
+    waitUs_ = reg->GetHistogram("webserver_cpu_task_wait_seconds", "Time CPU tasks spent queued.", label);
+    runUs_ = reg->GetHistogram("webserver_cpu_task_run_seconds", "Time spent running CPU tasks.", label);
+    for(size_t i = 0; i < threadCount; i++) {
+        threads_.emplace_back(&CpuExecutor::Run_, this);
+    }
+}
+
+// 析构函数：已入队的任务照常执行或过期后退出
+CpuExecutor::~CpuExecutor() {
+    {
+        lock_guard<mutex> locker(mtx_);
+        isClosed_ = true;
+    }
+    cond_.notify_all();
+    for(auto& t : threads_) { t.join(); }
+}
+
+// 提交任务，队列已满或已关闭时返回 false，两个回调都不会被调用
+bool CpuExecutor::Submit(function<void()> task, function<void()> expired) {
+    {
+        lock_guard<mutex> locker(mtx_);
+        if(isClosed_ || tasks_.size() >= maxQueue_) {
+            rejected_->Inc();
+            return false;
+        }
+        tasks_.push({ move(task), move(expired), MetricsNowUs() });
+    }
+    cond_.notify_one();
+    return true;
+}
+
+size_t CpuExecutor::QueueSize() {
+    lock_guard<mutex> locker(mtx_);
+    return tasks_.size();
+}
+
+void CpuExecutor::Run_() {
+    unique_lock<mutex> locker(mtx_);
+    while(true) {
+        if(!tasks_.empty()) {
+            Task task = move(tasks_.front());
+            tasks_.pop();
+            locker.unlock();
+            int64_t start = MetricsNowUs();
+            waitUs_->Record(start - task.enqueueUs);
+            if(start - task.enqueueUs > maxWaitUs_) {
+                expired_->Inc();
+                task.expired();
+            } else {
+                task.run();
+                runUs_->Record(MetricsNowUs() - start);
+            }
+            locker.lock();
+        }
+        else if(isClosed_) break;
+        else cond_.wait(locker);
+    }
+}
@@ -0,0 +1,53 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#ifndef CPUEXECUTOR_H
+#define CPUEXECUTOR_H
+
+#include <mutex>
+#include <condition_variable>
+#include <queue>
+#include <vector>
+#include <thread>
+#include <functional>
+#include <assert.h>
+#include "../metrics/metrics.h"
+
+// 计算密集任务的执行器（如密码哈希），与处理请求的线程池分开，线程数可以单独规划。
+// 队列有上限，满时拒绝提交；任务排队超过 maxWaitMs 时不再执行，改为调用其 expired 回调，
+// 积压时尽快让请求失败，而不是继续为已经等太久的请求消耗 CPU
+class CpuExecutor {
+public:
+    CpuExecutor(const std::string& name, size_t threadCount, size_t maxQueue, int maxWaitMs);
+
+    ~CpuExecutor();
+
+    bool Submit(std::function<void()> task, std::function<void()> expired);
+
+    size_t QueueSize();
+
+private:
+    struct Task {
+        std::function<void()> run;
+        std::function<void()> expired;
+        int64_t enqueueUs;
+    };
+
+    void Run_();
+
+    size_t maxQueue_;
+    int64_t maxWaitUs_;
+    bool isClosed_;
+    std::mutex mtx_;
+    std::condition_variable cond_;
+    std::queue<Task> tasks_;
+    std::vector<std::thread> threads_;
+    Counter* rejected_; // 队列已满被拒绝的任务
+    Counter* expired_;  // 排队超时未执行的任务
+    Histogram* waitUs_; // 排队时间
+    Histogram* runUs_;  // 执行时间
+};
+
+#endif //CPUEXECUTOR_H
@@ -0,0 +1,124 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#include "dbexecutor.h"
+
+using namespace std;
+
+// 构造函数：线程数一般与数据库连接池大小相同，每个线程执行时占用一个连接
+DbExecutor::DbExecutor(size_t threadCount, size_t maxQueue, int maxWaitMs)
+    : maxQueue_(maxQueue), maxWaitUs_(static_cast<int64_t>(maxWaitMs) * 1000), isClosed_(false) {
+    assert(threadCount > 0 && maxQueue > 0 && maxWaitMs > 0);
+    eventFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    assert(eventFd_ >= 0);
+    MetricsRegistry* reg = MetricsRegistry::Instance();
+    rejected_ = reg->GetCounter("webserver_db_jobs_rejected_total", "Database jobs rejected because the queue was full.");
+    expired_ = reg->GetCounter("webserver_db_jobs_expired_total", "Database jobs dropped after waiting too long in the queue.");
+    for(size_t i = 0; i < threadCount; i++) {
+        threads_.emplace_back(&DbExecutor::Run_, this);
+    }
+}
+
+DbExecutor::~DbExecutor() {
+    Stop();
+    close(eventFd_);
+}
+
+// 执行完已提交的操作后结束数据库线程；之后仍可以调用 Complete 放入结果，供其他执行器收尾
+void DbExecutor::Stop() {
+    {
+        lock_guard<mutex> locker(mtx_);
+        isClosed_ = true;
+    }
+    cond_.notify_all();
+    for(auto& t : threads_) {
+        if(t.joinable()) { t.join(); }
+    }
+}
+
+// 提交一个数据库操作，job 在数据库线程中执行，返回值随完成通知交回
+void DbExecutor::Submit(uint64_t connId, function<bool()> job) {
+    Post(connId, [this, connId, job] {
+        Completion c;
+        c.connId = connId;
+        c.startUs = MetricsNowUs();
+        c.ok = job();
+        c.doneUs = MetricsNowUs();
+        Complete(c);
+    });
+}
+
+// 在数据库线程中执行 job，不自动产生完成结果；用于查询后还要交给其他执行器继续处理的操作，
+// 由 job 或后续步骤调用 Complete 交回结果。被拒绝或排队超时的 job 不会执行，由执行器为 connId 放入失败的结果
+void DbExecutor::Post(uint64_t connId, function<void()> job) {
+    {
+        lock_guard<mutex> locker(mtx_);
+        if(!isClosed_ && jobs_.size() < maxQueue_) {
+            jobs_.push({ connId, move(job), MetricsNowUs() });
+            cond_.notify_one();
+            return;
+        }
+    }
+    rejected_->Inc();
+    Fail_(connId);
+}
+
+// 为 connId 放入一个失败的完成结果
+void DbExecutor::Fail_(uint64_t connId) {
+    int64_t now = MetricsNowUs();
+    Complete({ connId, false, now, now });
+}
+
+// 取走全部已完成的操作，事件循环在 eventfd 可读时调用
+void DbExecutor::TakeCompletions(vector<Completion>& out) {
+    uint64_t cnt = 0;
+    while(read(eventFd_, &cnt, sizeof(cnt)) > 0) {}
+    out.clear();
+    lock_guard<mutex> locker(doneMtx_);
+    out.swap(done_);
+}
+
+// 放入一个完成结果，完成队列由空变为非空时才写 eventfd；
+// 数据库线程执行完操作后调用，其他线程（如批量注册）也可以借此把结果交回事件循环
+void DbExecutor::Complete(const Completion& c) {
+    bool wake;
+    {
+        lock_guard<mutex> doneLocker(doneMtx_);
+        wake = done_.empty();
+        done_.push_back(c);
+    }
+    if(wake) {
+        uint64_t one = 1;
+        ssize_t n = write(eventFd_, &one, sizeof(one));
+        (void)n;
+    }
+}
+
+// 等待执行的操作数
+size_t DbExecutor::QueueSize() {
+    lock_guard<mutex> locker(mtx_);
+    return jobs_.size();
+}
+
+// 数据库线程：取出操作执行
+void DbExecutor::Run_() {
+    unique_lock<mutex> locker(mtx_);
+    while(true) {
+        if(!jobs_.empty()) {
+            Job job = move(jobs_.front());
+            jobs_.pop();
+            locker.unlock();
+            if(MetricsNowUs() - job.enqueueUs > maxWaitUs_) {
+                expired_->Inc();
+                Fail_(job.connId);
+            } else {
+                job.run();
+            }
+            locker.lock();
+        }
+        else if(isClosed_) break;
+        else cond_.wait(locker);
+    }
+}
@@ -0,0 +1,77 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#ifndef DBEXECUTOR_H
+#define DBEXECUTOR_H
+
+#include <mutex>
+#include <condition_variable>
+#include <queue>
+#include <vector>
+#include <thread>
+#include <functional>
+#include <unistd.h>        // read, write, close
+#include <sys/eventfd.h>   // eventfd
+#include <assert.h>
+#include "../metrics/metrics.h"
+
+// 数据库执行器：专用线程执行阻塞的数据库操作，完成结果放入完成队列并写 eventfd 通知事件循环。
+// 登录注册等请求不再占用处理静态文件的工作线程，数据库变慢时静态请求不受影响。
+// 队列有上限，满时拒绝提交；排队超过 maxWaitMs 的操作不再执行。两种情况都立即放入失败的完成结果，
+// 数据库变慢时请求尽快失败，而不是无限积压
+class DbExecutor {
+public:
+    // 一个已完成的数据库操作
+    struct Completion {
+        uint64_t connId;  // 发起请求的连接 id，事件循环据此找回连接，连接已关闭或复用时丢弃结果
+        bool ok;          // 操作结果
+        int64_t startUs;  // 开始执行的单调时钟时间（微秒）
+        int64_t doneUs;   // 执行完成的时间
+    };
+
+    DbExecutor(size_t threadCount, size_t maxQueue, int maxWaitMs);
+
+    ~DbExecutor();
+
+    void Stop();
+
+    int EventFd() const { return eventFd_; }
+
+    void Submit(uint64_t connId, std::function<bool()> job);
+
+    void Post(uint64_t connId, std::function<void()> job);
+
+    void TakeCompletions(std::vector<Completion>& out);
+
+    void Complete(const Completion& c);
+
+    size_t QueueSize();
+
+private:
+    struct Job {
+        uint64_t connId;
+        std::function<void()> run;
+        int64_t enqueueUs;
+    };
+
+    void Run_();
+
+    void Fail_(uint64_t connId);
+
+    size_t maxQueue_;
+    int64_t maxWaitUs_;
+    int eventFd_;
+    bool isClosed_;
+    std::mutex mtx_; // 保护任务队列与 isClosed_
+    std::condition_variable cond_;
+    std::queue<Job> jobs_;
+    std::mutex doneMtx_; // 保护完成队列
+    std::vector<Completion> done_;
+    std::vector<std::thread> threads_;
+    Counter* rejected_; // 队列已满或已停止被拒绝的操作
+    Counter* expired_;  // 排队超时未执行的操作
+};
+
+#endif //DBEXECUTOR_H
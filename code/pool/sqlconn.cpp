@@ -0,0 +1,68 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#include "sqlconn.h"
+
+using namespace std;
+
+SqlConn::SqlConn(MYSQL* sql) : sql_(sql), broken_(false), idleSinceUs_(0) {
+    assert(sql_);
+}
+
+// 析构函数：先关闭语句再关闭连接
+SqlConn::~SqlConn() {
+    for(auto& item : stmts_) { mysql_stmt_close(item.second); }
+    mysql_close(sql_);
+}
+
+// 取得 query 对应的预处理语句，首次使用时在服务端预处理，之后直接复用
+MYSQL_STMT* SqlConn::Prepare(const string& query) {
+    auto it = stmts_.find(query);
+    if(it != stmts_.end()) { return it->second; }
+    MYSQL_STMT* stmt = mysql_stmt_init(sql_);
+    if(!stmt) {
+        LOG_ERROR("MySql stmt init error!");
+        return nullptr;
+    }
+    if(mysql_stmt_prepare(stmt, query.data(), query.size())) {
+        LOG_ERROR("MySql prepare error: %s", mysql_stmt_error(stmt));
+        CheckBroken_(mysql_stmt_errno(stmt));
+        mysql_stmt_close(stmt);
+        return nullptr;
+    }
+    stmts_[query] = stmt;
+    return stmt;
+}
+
+// 执行出错后丢弃语句（如连接断开后语句在服务端已失效），下次使用时重新预处理
+void SqlConn::Discard(const string& query) {
+    auto it = stmts_.find(query);
+    if(it == stmts_.end()) { return; }
+    CheckBroken_(mysql_stmt_errno(it->second));
+    mysql_stmt_close(it->second);
+    stmts_.erase(it);
+}
+
+// 检查空闲连接是否可用，失败后连接标记为损坏
+bool SqlConn::Ping() {
+    if(!broken_ && mysql_ping(sql_) != 0) {
+        LOG_WARN("MySql ping error: %s", mysql_error(sql_));
+        broken_ = true;
+    }
+    return !broken_;
+}
+
+// 服务端返回的错误（如违反唯一键）不影响连接，客户端错误码说明连接已不可用
+void SqlConn::CheckBroken_(unsigned int err) {
+    if(err >= CR_MIN_ERROR && err <= CR_MAX_ERROR) { broken_ = true; }
+}
+
+void SqlConn::BindString(MYSQL_BIND& bind, char* buffer, unsigned long capacity, unsigned long* length) {
+    memset(&bind, 0, sizeof(bind));
+    bind.buffer_type = MYSQL_TYPE_STRING;
+    bind.buffer = buffer;
+    bind.buffer_length = capacity;
+    bind.length = length;
+}
@@ -0,0 +1,52 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#ifndef SQLCONN_H
+#define SQLCONN_H
+
+#include <mysql/mysql.h>
+#include <mysql/errmsg.h> // CR_MIN_ERROR, CR_MAX_ERROR
+#include <string>
+#include <unordered_map>
+#include <string.h>    // memset
+#include <stdint.h>
+#include <assert.h>
+#include "../log/log.h"
+
+// 连接池中的一个数据库连接，附带该连接上已预处理的语句。
+// 预处理语句属于创建它的连接，同一时刻只有取得该连接的线程使用，因此缓存无需加锁
+class SqlConn {
+public:
+    explicit SqlConn(MYSQL* sql);
+
+    ~SqlConn();
+
+    MYSQL* Get() const { return sql_; }
+
+    MYSQL_STMT* Prepare(const std::string& query);
+
+    void Discard(const std::string& query);
+
+    bool Ping();
+
+    // 出现客户端错误（连接断开、读写超时等）后连接不可再用，归还时由连接池关闭
+    bool IsBroken() const { return broken_; }
+
+    int64_t IdleSince() const { return idleSinceUs_; }
+    void SetIdleSince(int64_t us) { idleSinceUs_ = us; }
+
+    // 以字符串类型绑定一个参数或结果列，buffer 与 length 须在语句执行、取结果期间有效
+    static void BindString(MYSQL_BIND& bind, char* buffer, unsigned long capacity, unsigned long* length);
+
+private:
+    void CheckBroken_(unsigned int err);
+
+    MYSQL* sql_;
+    bool broken_;
+    int64_t idleSinceUs_; // 最近一次归还连接池的时间（单调时钟，微秒）
+    std::unordered_map<std::string, MYSQL_STMT*> stmts_; // SQL 文本 -> 预处理语句
+};
+
+#endif //SQLCONN_H
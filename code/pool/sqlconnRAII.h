@@ -12,7 +12,7 @@
 class SqlConnRAII {
 public:
     // 构造函数
-    SqlConnRAII(MYSQL** sql, SqlConnPool *connpool) {
+    SqlConnRAII(SqlConn** sql, SqlConnPool *connpool) {
         assert(connpool);
         *sql = connpool->GetConn();
         sql_ = *sql;
@@ -25,7 +25,7 @@ public:
     }
     
 private:
-    MYSQL *sql_;
+    SqlConn *sql_;
     SqlConnPool* connpool_;
 };
 
@@ -8,10 +8,21 @@
 
 using namespace std;
 
+const int SqlConnPool::HEALTH_INTERVAL_MS;
+
 // 默认构造函数
 SqlConnPool::SqlConnPool() {
-    useCount_ = 0; // 正在使用的连接数
-    freeCount_ = 0; // 空闲的连接数
+    MIN_CONN_ = MAX_CONN_ = 0;
+    waitMs_ = 0;
+    total_ = 0; // 已建立的连接数
+    connecting_ = 0; // 正在建立的连接数
+    lastFailUs_ = 0;
+    isClosed_ = true; // Init 之前视为关闭
+    MetricsRegistry *reg = MetricsRegistry::Instance();
+    waitUs_ = reg->GetHistogram("webserver_sql_pool_wait_seconds", "Time spent waiting for a SQL connection.");
+    timeouts_ = reg->GetCounter("webserver_sql_pool_timeouts_total", "SQL connection requests that timed out.");
+    connectErrors_ = reg->GetCounter("webserver_sql_pool_connect_errors_total", "Failed attempts to open a SQL connection.");
+    broken_ = reg->GetCounter("webserver_sql_pool_broken_total", "SQL connections closed after a client error or failed ping.");
 }
 
 // 获取 SqlConnPool 类的单例对象
@@ -21,62 +32,183 @@ SqlConnPool *SqlConnPool::Instance() {
 }
 
 // 数据库连接池初始化
-// 主机名 host、端口号 port、用户名 user、密码 pwd、数据库名称 dbName 连接池的大小 connSize
+// 主机名 host、端口号 port、用户名 user、密码 pwd、数据库名称 dbName
+// 最小连接数 connSize、最大连接数 maxConn（不大于 connSize 时连接数固定）、取连接的最长等待时间 waitMs
 void SqlConnPool::Init(const char *host, int port,
                        const char *user, const char *pwd, const char *dbName,
-                       int connSize = 10) {
-    assert(connSize > 0);
-    for (int i = 0; i < connSize; i++) {
-        MYSQL *sql = nullptr; //创建一个MYSQL对象
-        sql = mysql_init(sql); // MYSQL进行初始化
-        if (!sql) { // 初始化失败
-            LOG_ERROR("MySql init error!");
-            assert(sql);
-        }
-        sql = mysql_real_connect(sql, host,
-                                 user, pwd,
-                                 dbName, port, nullptr, 0); // 连接到MySQL服务器
-        if (!sql) { // 连接失败
-            LOG_ERROR("MySql Connect error!");
+                       int connSize, int maxConn, int waitMs) {
+    assert(connSize > 0 && waitMs >= 0);
+    assert(isClosed_);
+    host_ = host;
+    user_ = user;
+    pwd_ = pwd;
+    dbName_ = dbName;
+    port_ = port;
+    MIN_CONN_ = connSize;
+    MAX_CONN_ = max(connSize, maxConn);
+    waitMs_ = waitMs;
+    isClosed_ = false;
+    mysql_library_init(0, nullptr, nullptr); // 多个线程会同时建立连接，先在主线程初始化客户端库
+    for (int i = 0; i < MIN_CONN_; i++) {
+        SqlConn *conn = Connect_();
+        if (!conn) { // 连接失败，由后台线程稍后补足
+            lastFailUs_ = MetricsNowUs();
+            break;
         }
-        connQue_.push(sql); // 加入数据库连接池队列
+        conn->SetIdleSince(MetricsNowUs());
+        connQue_.push_back(conn); // 加入数据库连接池队列
+        total_++;
     }
-    MAX_CONN_ = connSize;
-    sem_init(&semId_, 0, MAX_CONN_); // 初始化一个信号量，该信号量的初始值为 MAX_CONN_，并且在当前进程内部共享。
+    health_ = thread(&SqlConnPool::HealthCheck_, this);
 }
 
-// 从连接池中获取一个 MYSQL 连接对象
-MYSQL *SqlConnPool::GetConn() {
-    MYSQL *sql = nullptr; // 用于存储获取的 MYSQL 连接对象
-    if (connQue_.empty()) { // 检查连接池中是否有可用的连接
-        LOG_WARN("SqlConnPool busy!"); // 连接池忙碌，无法获取连接。
+// 建立一个连接，失败返回 nullptr；不持有锁时调用
+SqlConn *SqlConnPool::Connect_() {
+    MYSQL *sql = mysql_init(nullptr); // MYSQL进行初始化
+    if (!sql) { // 初始化失败
+        LOG_ERROR("MySql init error!");
         return nullptr;
     }
-    sem_wait(&semId_); // 使用信号量进行同步，等待可用连接
-    {
-        lock_guard <mutex> locker(mtx_); // 使用 std::lock_guard 对连接池的互斥量 mtx_ 进行加锁
-        sql = connQue_.front();
-        connQue_.pop();
+    unsigned int connectTimeout = CONNECT_TIMEOUT_S, ioTimeout = IO_TIMEOUT_S;
+    mysql_options(sql, MYSQL_OPT_CONNECT_TIMEOUT, &connectTimeout);
+    mysql_options(sql, MYSQL_OPT_READ_TIMEOUT, &ioTimeout);
+    mysql_options(sql, MYSQL_OPT_WRITE_TIMEOUT, &ioTimeout);
+    if (!mysql_real_connect(sql, host_.c_str(),
+                            user_.c_str(), pwd_.c_str(),
+                            dbName_.c_str(), port_, nullptr, 0)) { // 连接到MySQL服务器
+        LOG_ERROR("MySql Connect error: %s", mysql_error(sql));
+        mysql_close(sql);
+        connectErrors_->Inc();
+        return nullptr;
+    }
+    return new SqlConn(sql);
+}
+
+// 从连接池中获取一个连接对象：优先取最近归还的空闲连接，没有空闲连接且未达上限时新建，
+// 否则等待其他线程归还，超过 waitMs 返回 nullptr
+SqlConn *SqlConnPool::GetConn() {
+    int64_t start = MetricsNowUs();
+    auto deadline = chrono::steady_clock::now() + chrono::milliseconds(waitMs_);
+    unique_lock<mutex> locker(mtx_);
+    while (!isClosed_) {
+        if (!connQue_.empty()) {
+            SqlConn *conn = connQue_.front();
+            connQue_.pop_front();
+            locker.unlock();
+            waitUs_->Record(MetricsNowUs() - start);
+            return conn;
+        }
+        if (total_ + connecting_ < MAX_CONN_ && MetricsNowUs() - lastFailUs_ >= RETRY_MS * 1000LL) {
+            connecting_++;
+            locker.unlock();
+            SqlConn *conn = Connect_();
+            locker.lock();
+            connecting_--;
+            if (conn) {
+                total_++;
+                locker.unlock();
+                waitUs_->Record(MetricsNowUs() - start);
+                return conn;
+            }
+            lastFailUs_ = MetricsNowUs();
+            continue;
+        }
+        if (cond_.wait_until(locker, deadline) == cv_status::timeout && connQue_.empty()) { break; }
     }
-    return sql;
+    locker.unlock();
+    timeouts_->Inc();
+    LOG_WARN("SqlConnPool busy!"); // 连接池忙碌或数据库不可用，无法获取连接。
+    return nullptr;
 }
 
-// 将不再使用的 MYSQL 连接对象放回连接池中
-void SqlConnPool::FreeConn(MYSQL *sql) {
-    assert(sql);
-    lock_guard <mutex> locker(mtx_); // 使用 std::lock_guard 对连接池的互斥量 mtx_ 进行加锁
-    connQue_.push(sql);
-    sem_post(&semId_); // 使用信号量进行同步，增加可用连接的计数。
+// 将不再使用的连接对象放回连接池中，损坏的连接直接关闭
+void SqlConnPool::FreeConn(SqlConn *conn) {
+    assert(conn);
+    if (conn->IsBroken()) {
+        delete conn;
+        broken_->Inc();
+        lock_guard <mutex> locker(mtx_);
+        total_--;
+        cond_.notify_one(); // 连接数减少，等待的线程可以新建连接
+        return;
+    }
+    conn->SetIdleSince(MetricsNowUs());
+    lock_guard <mutex> locker(mtx_);
+    connQue_.push_front(conn);
+    cond_.notify_one();
 }
 
-// 关闭连接池并释放所有连接资源
+// 后台检查：空闲最久的连接在队列尾部，依次处理空闲超过 IDLE_PING_MS 的连接，
+// 多于最小连接数且空闲超过 IDLE_CLOSE_MS 的关闭，其余 ping 一次；最后把连接数补回最小值
+void SqlConnPool::HealthCheck_() {
+    unique_lock<mutex> locker(mtx_);
+    while (!isClosed_) {
+        healthCond_.wait_for(locker, chrono::milliseconds(HEALTH_INTERVAL_MS));
+        if (isClosed_) { break; }
+        int64_t now = MetricsNowUs();
+        vector<SqlConn *> expired, checked;
+        while (!connQue_.empty() && now - connQue_.back()->IdleSince() >= IDLE_PING_MS * 1000LL) {
+            SqlConn *conn = connQue_.back();
+            connQue_.pop_back();
+            if (total_ > MIN_CONN_ && now - conn->IdleSince() >= IDLE_CLOSE_MS * 1000LL) {
+                expired.push_back(conn);
+                total_--;
+            } else {
+                checked.push_back(conn);
+            }
+        }
+        locker.unlock();
+        for (SqlConn *conn : expired) { delete conn; }
+        int dead = 0;
+        for (SqlConn *&conn : checked) {
+            if (!conn->Ping()) {
+                delete conn;
+                conn = nullptr;
+                dead++;
+            }
+        }
+        broken_->Inc(dead);
+        locker.lock();
+        for (SqlConn *conn : checked) {
+            if (conn) { connQue_.push_back(conn); } // 放回尾部，保持按空闲时间排列
+        }
+        total_ -= dead;
+        if (!checked.empty()) { cond_.notify_all(); }
+        while (!isClosed_ && total_ + connecting_ < MIN_CONN_) {
+            connecting_++;
+            locker.unlock();
+            SqlConn *conn = Connect_();
+            locker.lock();
+            connecting_--;
+            if (!conn) {
+                lastFailUs_ = MetricsNowUs();
+                break;
+            }
+            conn->SetIdleSince(MetricsNowUs());
+            total_++;
+            connQue_.push_front(conn);
+            cond_.notify_one();
+        }
+    }
+}
+
+// 关闭连接池并释放所有连接资源，调用前应归还全部连接
 void SqlConnPool::ClosePool() {
+    {
+        lock_guard <mutex> locker(mtx_);
+        if (isClosed_) { return; }
+        isClosed_ = true;
+    }
+    healthCond_.notify_all();
+    cond_.notify_all();
+    health_.join();
     lock_guard <mutex> locker(mtx_);
     while (!connQue_.empty()) {
-        auto item = connQue_.front();
-        connQue_.pop();
-        mysql_close(item); // 关闭 MYSQL 连接对象，释放连接资源。
+        delete connQue_.front(); // 关闭预处理语句与 MYSQL 连接对象，释放连接资源。
+        connQue_.pop_front();
+        total_--;
     }
+    if (total_ > 0) { LOG_WARN("SqlConnPool closed with %d connections in use", total_); }
     mysql_library_end(); // 关闭 MySQL 客户端库，释放相关资源。
 }
 
@@ -86,6 +218,12 @@ int SqlConnPool::GetFreeConnCount() {
     return connQue_.size(); // 返回连接队列 connQue_ 的大小
 }
 
+// 已建立的连接数，含正在使用的
+int SqlConnPool::GetConnCount() {
+    lock_guard <mutex> locker(mtx_);
+    return total_;
+}
+
 // 析构函数
 SqlConnPool::~SqlConnPool() {
     ClosePool();
@@ -8,37 +8,69 @@
 
 #include <mysql/mysql.h>
 #include <string>
-#include <queue>
+#include <deque>
+#include <vector>
 #include <mutex>
-#include <semaphore.h>
+#include <condition_variable>
+#include <chrono>
 #include <thread>
 #include "../log/log.h"
+#include "../metrics/metrics.h"
+#include "sqlconn.h"
 
+// 弹性数据库连接池：启动时建立 minConn 个连接，空闲连接不够时按需增加到 maxConn 个，
+// 取连接最多等待 waitMs 毫秒。后台线程定期 ping 空闲较久的连接、关闭超过最小数量的长时间空闲连接，
+// 并把连接数补回最小值；损坏的连接归还时直接关闭，数据库短暂不可用后连接池可以自行恢复
 class SqlConnPool {
 public:
     static SqlConnPool *Instance();
 
-    MYSQL *GetConn();
-    void FreeConn(MYSQL * conn);
+    SqlConn *GetConn();
+    void FreeConn(SqlConn * conn);
     int GetFreeConnCount();
+    int GetConnCount();
 
     void Init(const char* host, int port,
               const char* user,const char* pwd, 
-              const char* dbName, int connSize);
+              const char* dbName, int connSize,
+              int maxConn = 0, int waitMs = 1000);
     void ClosePool();
 
 private:
     SqlConnPool();
     ~SqlConnPool();
 
+    SqlConn *Connect_();
+    void HealthCheck_();
+
+    static const int CONNECT_TIMEOUT_S = 3;       // 建立连接的超时
+    static const int IO_TIMEOUT_S = 5;            // 读写超时，数据库卡住时数据库线程不会一直阻塞
+    static const int RETRY_MS = 1000;             // 连接失败后至少间隔这么久才再次尝试
+    static const int HEALTH_INTERVAL_MS = 5000;   // 后台检查间隔
+    static const int IDLE_PING_MS = 30000;        // 空闲超过这么久的连接在检查时 ping
+    static const int IDLE_CLOSE_MS = 60000;       // 空闲超过这么久且多于最小连接数时关闭
+
+    std::string host_, user_, pwd_, dbName_; // 重新连接时使用
+    int port_;
+    int MIN_CONN_; // 最小连接数
     int MAX_CONN_; // 最大连接数
-    int useCount_; // 正在使用的连接数
-    int freeCount_; // 空闲的连接数
+    int waitMs_; // 取连接的最长等待时间
+    int total_; // 已建立的连接数，含空闲与正在使用的
+    int connecting_; // 正在建立的连接数
+    int64_t lastFailUs_; // 最近一次连接失败的时间
+    bool isClosed_;
 
-    std::queue<MYSQL *> connQue_; // 用于存放初始化好的sql数据库连接队列
+    std::deque<SqlConn *> connQue_; // 空闲连接，头部最近归还，尾部空闲最久
     std::mutex mtx_; // 互斥量
-    sem_t semId_; // 信号量
+    std::condition_variable cond_; // 等待空闲连接
+    std::condition_variable healthCond_; // 后台检查线程等待下一轮或关闭
+    std::thread health_;
+
+    Histogram *waitUs_; // 取连接的耗时
+    Counter *timeouts_; // 取连接超时次数
+    Counter *connectErrors_; // 建立连接失败次数
+    Counter *broken_; // 因损坏或 ping 失败关闭的连接数
 };
 
 
-#endif // SQLCONNPOOL_H
\ No newline at end of file
+#endif // SQLCONNPOOL_H
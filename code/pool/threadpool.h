@@ -12,6 +12,8 @@
 #include <queue>
 #include <thread>
 #include <functional>
+#include <memory>
+#include <assert.h>
 
 
 class ThreadPool {
@@ -19,6 +21,11 @@ public:
     // 带参构造函数
     explicit ThreadPool(size_t threadCount = 8): pool_(std::make_shared<Pool>()) {
             assert(threadCount > 0);
+            AddThreads(threadCount);
+    }
+
+    // 增加工作线程，运行中扩容时调用；线程与任务队列共享 pool_，不需要停下已有线程
+    void AddThreads(size_t threadCount) {
             for(size_t i = 0; i < threadCount; i++) {//根据线程数量创建线程
                 std::thread([pool = pool_] {
                     std::unique_lock<std::mutex> locker(pool->mtx); // 创建了一个独占锁 locker，锁定了线程池的互斥量 pool->mtx
@@ -35,6 +42,12 @@ public:
                     }
                 }).detach(); // 在循环中创建了一个新的线程，并使用 lambda 表达式作为线程的执行体
             }
+            threadCount_ += threadCount;
+    }
+
+    // 工作线程数
+    size_t ThreadCount() const {
+        return threadCount_;
     }
 
     // 默认构造函数
@@ -47,7 +60,7 @@ public:
     ~ThreadPool() {
         if(static_cast<bool>(pool_)) { // 检查 pool_ 的指针是否指向有效的对象
             {
-                std::lock_ugard<std::mutex> locker(pool_->mtx); // 创建了一个互斥量的独占锁 locker，并锁定了线程池对象中的互斥量 pool_->mtx
+                std::lock_guard<std::mutex> locker(pool_->mtx); // 创建了一个互斥量的独占锁 locker，并锁定了线程池对象中的互斥量 pool_->mtx
                 pool_->isClosed = true; // 表示线程池已关闭
             }
             pool_->cond.notify_all(); // 通知所有等待在条件变量 pool_->cond 上的线程
@@ -64,6 +77,12 @@ public:
         pool_->cond.notify_one(); // 通知一个等待在条件变量 pool_->cond 上的线程
     }
 
+    // 等待执行的任务数，用于监控
+    size_t QueueSize() {
+        std::lock_guard<std::mutex> locker(pool_->mtx);
+        return pool_->tasks.size();
+    }
+
 private:
     //线程池
     struct Pool {
@@ -73,6 +92,7 @@ private:
         std::queue<std::function<void()>> tasks; // 任务队列
     };
     std::shared_ptr<Pool> pool_;//线程池
+    size_t threadCount_ = 0; // 已创建的工作线程数，只由创建线程池的线程修改
 };
 
 
@@ -1,31 +1,74 @@
 #include "webserver.h"
 using namespace std;
 
+int WebServer::reloadFd_ = -1;
+
 // 端口 ET模式 timeoutMs 优雅退出
 // sql端口、账号、密码、数据库
-// 连接池数量 线程池数量 日志开关 日志等级 日志异步队列容量
+// 连接池数量 线程池数量 日志开关 日志等级 日志异步队列容量 请求追踪采样间隔 管理端口
+// 本地用户文件（为空时用户存放在 MySQL，否则不连接数据库） 最小连接数（0 表示与连接池数量相同） 取连接的最长等待时间
+// 密码哈希线程数 会话有效期（秒，0 不签发会话） 会话文件（为空时只保存在内存中）
 WebServer::WebServer(
         int port, int trigMode, int timeoutMS, bool OptLinger,
         int sqlPort, const char *sqlUser, const char *sqlPwd,
         const char *dbName, int connPoolNum, int threadNum,
-        bool openLog, int logLevel, int logQueSize) :
-        port_(port), openLinger_(OptLinger), timeoutMS_(timeoutMS), isClose_(false),
-        timer_(new HeapTimer()), threadpool_(new ThreadPool(threadNum)), epoller_(new Epoller()) {
+        bool openLog, int logLevel, int logQueSize, int traceSample, int adminPort, const char *authFile,
+        int connPoolMin, int sqlWaitMs, int hashThreads, int sessionTtlSec, const char *sessionFile) :
+        port_(port), openLinger_(OptLinger), timeoutMS_(timeoutMS), isClose_(false), adminPort_(adminPort), adminFd_(-1),
+        openLog_(openLog), traceSample_(traceSample),
+        timer_(new TimerService(std::bind(&WebServer::FindTimer_, this, std::placeholders::_1))), threadpool_(new ThreadPool(threadNum)), epoller_(new Epoller()) {
+    signal(SIGPIPE, SIG_IGN); // 客户端提前断开时 writev 返回 EPIPE，而不是让进程被 SIGPIPE 终止
     srcDir_ = getcwd(nullptr, 256); // 返回当前工作目录的路径名
     assert(srcDir_);
     strncat(srcDir_, "/resources/", 16); // 将"/resources/"字符串连接到末尾
     HttpConn::userCount = 0; // 连接的用户数量
     HttpConn::srcDir = srcDir_; // HTTP服务器的根目录
-    SqlConnPool::Instance()->Init("localhost", sqlPort, sqlUser, sqlPwd, dbName,
-                                  connPoolNum); // 创建一个数据库连接池
+    std::string authErr;
+    if (authFile && *authFile) {
+        LocalAuthStore *local = new LocalAuthStore();
+        authStore_.reset(local);
+        if (!local->Open(authFile, &authErr)) { isClose_ = true; }
+    } else {
+        authStore_.reset(new MysqlAuthStore("localhost", sqlPort, sqlUser, sqlPwd, dbName,
+                                            connPoolMin > 0 ? connPoolMin : connPoolNum, connPoolNum,
+                                            sqlWaitMs)); // 创建一个数据库连接池，连接数在最小值与 connPoolNum 之间伸缩
+    }
+    dbExecutor_.reset(new DbExecutor(connPoolNum, DB_QUEUE, DB_WAIT_MS)); // 每个数据库线程同一时刻只占用一个连接；排队最多 DB_QUEUE 个，超过 DB_WAIT_MS 的直接失败
+    DbExecutor *db = dbExecutor_.get();
+    registerBatcher_.reset(new RegisterBatcher(authStore_.get(), [db](uint64_t connId, bool ok, int64_t startUs, int64_t doneUs) {
+        db->Complete({ connId, ok, startUs, doneUs }); // 注册结果与登录一样经数据库执行器的完成队列交回事件循环
+    }));
+    // 每个线程同时只做一次哈希，约占 16MB 内存；排队最多 HASH_QUEUE 个，排队超过 HASH_WAIT_MS 的请求直接失败
+    hashExecutor_.reset(new CpuExecutor("password_hash", hashThreads, HASH_QUEUE, HASH_WAIT_MS));
+    std::string sessionErr;
+    if (sessionTtlSec > 0) { // 登录成功后签发会话，之后的请求凭 cookie 在内存中识别用户
+        sessions_.reset(new SessionStore(sessionTtlSec, SESSION_CAPACITY));
+        if (sessionFile && *sessionFile && !sessions_->Open(sessionFile, &sessionErr)) { isClose_ = true; }
+        HttpConn::sessions = sessions_.get();
+        timer_->Add(&sessionTimer_, SESSION_SWEEP_MS, std::bind(&WebServer::SweepSessions_, this));
+    }
 
     InitEventMode_(
             trigMode); // 初始化事件模式为ET模式(3)
     if (!InitSocket_()) { isClose_ = true; } // 初始化套接字
+    if (adminPort_ > 0) { // 只读的管理端口，单独一个线程收发
+        adminPool_.reset(new ThreadPool(1));
+        if (!InitAdminSocket_()) { isClose_ = true; }
+    }
+    epoller_->AddFd(timer_->TimerFd(), EPOLLIN); // 监听定时器到期
+    epoller_->AddFd(timer_->WakeupFd(), EPOLLIN); // 监听其他线程投递的定时器取消请求
+    epoller_->AddFd(dbExecutor_->EventFd(), EPOLLIN); // 监听数据库操作完成
+    InitMetrics_();
 
     // 日志记录
     if (openLog) {
-        Log::Instance()->init(logLevel, "./log", ".log", logQueSize); // 初始化日志记录器
+        Log::Instance()->init(logLevel, "./log", ".log", logQueSize, true); // 初始化日志记录器，异步模式下延迟到后台线程格式化
+        AccessLog::Instance()->init("./log"); // 结构化访问日志，按大小与时间切换文件
+        if (traceSample > 0) { // 每 traceSample 个请求采样一个，写成 Chrome trace-event 格式
+            RequestTracer::Instance()->Init("./log/trace.json", traceSample);
+        }
+        if (!authErr.empty()) { LOG_ERROR("%s", authErr.c_str()); }
+        if (!sessionErr.empty()) { LOG_ERROR("%s", sessionErr.c_str()); }
         if (isClose_) { LOG_ERROR("========== Server init error!=========="); } // 如果 isClose_ 为 true，表示服务器初始化出错
         else {
             LOG_INFO("========== Server init ==========");
@@ -35,17 +78,155 @@ WebServer::WebServer(
                      (connEvent_ & EPOLLET ? "ET" : "LT"));
             LOG_INFO("LogSys level: %d", logLevel);
             LOG_INFO("srcDir: %s", HttpConn::srcDir);
-            LOG_INFO("SqlConnPool num: %d, ThreadPool num: %d", connPoolNum, threadNum);
+            LOG_INFO("AuthStore: %s, SqlConnPool num: %d, ThreadPool num: %d", authStore_->Name(), connPoolNum, threadNum);
         }
     }
 }
 
 // 析构函数
 WebServer::~WebServer() {
+    MetricsRegistry::Instance()->Remove("webserver_threadpool_queue_depth"); // 回调引用了线程池与数据库执行器，先注销
+    MetricsRegistry::Instance()->Remove("webserver_db_queue_depth");
+    MetricsRegistry::Instance()->Remove("webserver_register_queue_depth");
+    MetricsRegistry::Instance()->Remove("webserver_hash_queue_depth");
+    MetricsRegistry::Instance()->Remove("webserver_sessions");
+    timer_->Clear(); // 先摘除所有嵌入在连接中的定时器节点
     close(listenFd_); // 关闭服务器的监听套接字 listenFd_
+    if (adminFd_ >= 0) { close(adminFd_); }
+    if (reloadFd_ >= 0) {
+        signal(SIGHUP, SIG_DFL);
+        close(reloadFd_);
+        reloadFd_ = -1;
+    }
     isClose_ = true; // 表示服务器已关闭
     free(srcDir_); // 释放存储资源目录路径的内存空间
-    SqlConnPool::Instance()->ClosePool(); // 关闭数据库连接池
+    // 按任务流向依次收尾：数据库查询可能提交哈希，哈希可能提交注册，它们的结果都放入数据库执行器的完成队列
+    dbExecutor_->Stop();
+    hashExecutor_.reset();
+    registerBatcher_.reset();
+    dbExecutor_.reset();
+    authStore_.reset(); // 最后关闭用户存储
+}
+
+// 登记服务器级别的指标；定时器只归主线程访问，其数量由事件循环写入，其余数值在抓取时读取
+void WebServer::InitMetrics_() {
+    MetricsRegistry* reg = MetricsRegistry::Instance();
+    acceptsMetric_ = reg->GetCounter("webserver_accepts_total", "Accepted client connections.");
+    timersMetric_ = reg->GetGauge("webserver_timers", "Timers in the timing wheel.");
+    reg->AddCallback("webserver_connections", "Open client connections.", "", false,
+                     [] { return static_cast<double>(HttpConn::userCount.load()); });
+    ThreadPool* pool = threadpool_.get();
+    reg->AddCallback("webserver_threadpool_queue_depth", "Tasks waiting in the thread pool queue.", "", false,
+                     [pool] { return static_cast<double>(pool->QueueSize()); });
+    DbExecutor* db = dbExecutor_.get();
+    reg->AddCallback("webserver_db_queue_depth", "Database operations waiting for a DB thread.", "", false,
+                     [db] { return static_cast<double>(db->QueueSize()); });
+    RegisterBatcher* batcher = registerBatcher_.get();
+    reg->AddCallback("webserver_register_queue_depth", "Registrations waiting to be written in a batch.", "", false,
+                     [batcher] { return static_cast<double>(batcher->QueueSize()); });
+    CpuExecutor* hasher = hashExecutor_.get();
+    reg->AddCallback("webserver_hash_queue_depth", "Password hashes waiting for a hash thread.", "", false,
+                     [hasher] { return static_cast<double>(hasher->QueueSize()); });
+    if (sessions_) {
+        SessionStore* sessions = sessions_.get();
+        reg->AddCallback("webserver_sessions", "Live login sessions.", "", false,
+                         [sessions] { return static_cast<double>(sessions->Size()); });
+    }
+    reg->AddCallback("webserver_sql_free_connections", "Idle connections in the SQL pool.", "", false,
+                     [] { return static_cast<double>(SqlConnPool::Instance()->GetFreeConnCount()); });
+    reg->AddCallback("webserver_sql_connections", "Open connections in the SQL pool, idle or in use.", "", false,
+                     [] { return static_cast<double>(SqlConnPool::Instance()->GetConnCount()); });
+    reg->AddCallback("webserver_log_dropped_total", "Log lines dropped because a ring was full.", "", true,
+                     [] { return static_cast<double>(Log::Instance()->GetDroppedTotal()); });
+    reg->AddCallback("webserver_access_log_dropped_total", "Access log records dropped because a ring was full.", "", true,
+                     [] { return static_cast<double>(AccessLog::Instance()->GetDropped()); });
+}
+
+// 开启配置重新加载：记录启动时的配置，收到 SIGHUP 后在事件循环中重新读取 confPath
+bool WebServer::EnableReload(const std::string& confPath) {
+    assert(reloadFd_ < 0);
+    confPath_ = confPath;
+    std::string err;
+    if (!bootConf_.Load(confPath_, &err)) { LOG_WARN("Config: %s", err.c_str()); } // 没有配置文件时按空配置比较
+    reloadFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (reloadFd_ < 0 || epoller_->AddFd(reloadFd_, EPOLLIN) == 0) {
+        LOG_ERROR("Init reload eventfd error!");
+        return false;
+    }
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = OnSighup_;
+    sa.sa_flags = SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGHUP, &sa, nullptr);
+    return true;
+}
+
+// SIGHUP 处理函数：只写 eventfd（异步信号安全），真正的重新加载在事件循环中进行
+void WebServer::OnSighup_(int) {
+    int savedErrno = errno;
+    uint64_t one = 1;
+    ssize_t n = write(reloadFd_, &one, sizeof(one));
+    (void)n;
+    errno = savedErrno;
+}
+
+// 重新读取配置文件：先完整解析与校验，全部通过后才在事件循环中一起生效，任何一项出错则整份放弃。
+// 可在运行中修改的只有日志级别与溢出策略、超时时间、线程数（只增不减）和请求追踪采样间隔，
+// 其余项（端口、触发模式、数据库、连接池大小等）需要重启，修改时只记录告警
+void WebServer::ReloadConfig_() {
+    Config conf;
+    std::string err;
+    if (!conf.Load(confPath_, &err)) {
+        LOG_ERROR("Reload config failed: %s", err.c_str());
+        return;
+    }
+    int logLevel = Log::Instance()->GetLevel();
+    int timeoutMS = timeoutMS_;
+    int threadNum = static_cast<int>(threadpool_->ThreadCount());
+    int traceSample = traceSample_;
+    int blockMs = 10;
+    std::string policy;
+    bool valid = conf.ReadInt("log_level", &logLevel) && logLevel >= 0 && logLevel <= 3
+        && conf.ReadInt("timeout_ms", &timeoutMS) && (timeoutMS > 0) == (timeoutMS_ > 0) // 开关超时需要重启
+        && conf.ReadInt("thread_num", &threadNum) && threadNum >= static_cast<int>(threadpool_->ThreadCount())
+        && conf.ReadInt("trace_sample", &traceSample) && traceSample >= 0
+        && conf.ReadInt("log_block_timeout_ms", &blockMs) && blockMs >= 0
+        && conf.ReadString("log_overflow_policy", &policy)
+        && (policy.empty() || policy == "drop" || policy == "drop_low_level" || policy == "block");
+    if (!valid) {
+        LOG_ERROR("Reload config failed: invalid value in %s", confPath_.c_str());
+        return;
+    }
+
+    static const char* RESTART_KEYS[] = {
+        "port", "trig_mode", "opt_linger", "sql_port", "sql_user", "sql_pwd", "db_name",
+        "conn_pool_num", "conn_pool_min", "sql_wait_ms", "hash_threads", "open_log", "log_queue_size", "admin_port", "auth_store", "auth_file",
+        "session_ttl_s", "session_file"
+    };
+    for (const char* key : RESTART_KEYS) {
+        std::string before, after;
+        bootConf_.ReadString(key, &before);
+        conf.ReadString(key, &after);
+        if (before != after) { LOG_WARN("Config %s changed, restart required", key); }
+    }
+
+    Log::Instance()->SetLevel(logLevel);
+    if (!policy.empty()) {
+        Log::Instance()->SetOverflowPolicy(policy == "drop" ? Log::DROP :
+                                           policy == "drop_low_level" ? Log::DROP_LOW_LEVEL : Log::BLOCK_TIMEOUT,
+                                           blockMs);
+    }
+    timeoutMS_ = timeoutMS; // 已有定时器到期时按新的超时时间重新计算剩余时间
+    if (threadNum > static_cast<int>(threadpool_->ThreadCount())) {
+        threadpool_->AddThreads(threadNum - threadpool_->ThreadCount());
+    }
+    if (traceSample != traceSample_ && openLog_) { // 重新打开采样文件
+        RequestTracer::Instance()->Init("./log/trace.json", traceSample);
+        traceSample_ = traceSample;
+    }
+    LOG_INFO("Config reloaded: log_level %d, timeout_ms %d, thread_num %d, trace_sample %d",
+             logLevel, timeoutMS, threadNum, traceSample_);
 }
 
 // 初始化事件模式
@@ -75,19 +256,27 @@ void WebServer::InitEventMode_(int trigMode) {
 
 // 服务器的主事件循环
 void WebServer::Start() {
-    int timeMS = -1;  // epoll等待的超时时间为无限
     if (!isClose_) { LOG_INFO("========== Server start =========="); } // 记录信息日志表示服务器已经启动。
     while (!isClose_) {
-        if (timeoutMS_ > 0) { // 如果设置了超时时间
-            timeMS = timer_->GetNextTick(); // 获取下一个计时器超时时间
-        }
-        int eventCnt = epoller_->Wait(timeMS); // 等待事件发生,当有事件发生时,获取事件数量
+        int eventCnt = epoller_->Wait(); // 等待事件发生，定时器到期由 timerfd 唤醒，无需每轮计算超时时间
         for (int i = 0; i < eventCnt; i++) { // 遍历处理每个事件
 
             int fd = epoller_->GetEventFd(i);
             uint32_t events = epoller_->GetEvents(i);
             if (fd == listenFd_) { // 事件是监听套接字实例
                 DealListen_(); // 处理监听事件
+            } else if (fd == adminFd_) { // 管理端口的连接
+                DealAdmin_();
+            } else if (fd == dbExecutor_->EventFd()) { // 数据库操作完成
+                DealDbCompletions_();
+            } else if (fd == reloadFd_) { // 收到 SIGHUP
+                uint64_t cnt = 0;
+                while (read(reloadFd_, &cnt, sizeof(cnt)) > 0) {}
+                ReloadConfig_();
+            } else if (fd == timer_->TimerFd()) { // 定时器到期
+                timer_->HandleTimer();
+            } else if (fd == timer_->WakeupFd()) { // 工作线程投递的定时器取消请求
+                timer_->HandleWakeup();
             } else if (events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR)) { // 错误事件或连接关闭事件
                 assert(users_.count(fd) > 0);
                 CloseConn_(&users_[fd]); // 关闭用户连接
@@ -101,6 +290,7 @@ void WebServer::Start() {
                 LOG_ERROR("Unexpected event"); // 错误日志
             }
         }
+        timersMetric_->Set(static_cast<int64_t>(timer_->Size())); // 只写一个原子值
     }
 }
 
@@ -115,11 +305,14 @@ void WebServer::SendError_(int fd, const char *info) {
 }
 
 // 用于关闭客户端连接
+// 主线程（超时、对端关闭）与工作线程（读写出错）都会调用
 void WebServer::CloseConn_(HttpConn *client) {
     assert(client);
+    uint64_t connId = client->GetConnId(); // 关闭 fd 之前取出 id，fd 之后可能立刻被新连接复用
     LOG_INFO("Client[%d] quit!", client->GetFd());
     epoller_->DelFd(client->GetFd()); // 从 epoll 实例中删除客户端的文件描述符
     client->Close(); // 关闭客户端连接
+    if (timeoutMS_ > 0) { timer_->Cancel(connId); } // 取消定时器，工作线程中调用时经 eventfd 交给主线程执行
 }
 
 // 添加新的客户端连接
@@ -127,8 +320,9 @@ void WebServer::AddClient_(int fd, sockaddr_in addr) {
     assert(fd > 0);
     users_[fd].init(fd, addr); // 初始化新的连接
     if (timeoutMS_ > 0) { // 添加超时时间
-        timer_->add(fd, timeoutMS_, std::bind(&WebServer::CloseConn_, this,
-                                              &users_[fd])); // 为连接添加计时器。
+        users_[fd].Touch(TimeWheel::NowMs());
+        timer_->Add(users_[fd].GetTimer(), timeoutMS_, std::bind(&WebServer::OnTimeout_, this,
+                                              users_[fd].GetConnId())); // 为连接添加计时器，回调只携带带代数的 id
     }
     epoller_->AddFd(fd,
                     EPOLLIN | connEvent_); // 将文件描述符添加到epoll实例中，监听事件类型为可读事件和连接事件。
@@ -143,7 +337,8 @@ void WebServer::DealListen_() {
     do {
         int fd = accept(listenFd_, (struct sockaddr *) &addr, &len); // 接受客户端的连接请求
         if (fd <= 0) { return; }
-        else if (HttpConn::userCount >= MAX_FD) { // 服务器用户连接数已满
+        acceptsMetric_->Inc();
+        if (HttpConn::userCount >= MAX_FD) { // 服务器用户连接数已满
             SendError_(fd, "Server busy!");
             LOG_WARN("Clients is full!");
             return;
@@ -152,24 +347,121 @@ void WebServer::DealListen_() {
     } while (listenEvent_ & EPOLLET); // 监听事件采用了边缘触发模式
 }
 
+// 处理管理端口的连接：快照在事件循环中生成（users_ 与定时器只归主线程访问，无需加锁），
+// 收发交给专用的管理线程，慢速的管理客户端既不阻塞事件循环，也不占用处理请求的线程池；
+// 排队已满或排队过久的连接直接关闭
+void WebServer::DealAdmin_() {
+    while (true) {
+        int fd = accept4(adminFd_, nullptr, nullptr, SOCK_CLOEXEC); // 阻塞套接字，由管理线程带超时收发
+        if (fd < 0) { return; }
+        if (adminPool_->QueueSize() >= ADMIN_QUEUE) {
+            LOG_WARN("Admin queue is full!");
+            close(fd);
+            continue;
+        }
+        std::string body = AdminSnapshot_();
+        int64_t acceptMs = TimeWheel::NowMs();
+        adminPool_->AddTask([fd, acceptMs, body = std::move(body)] {
+            if (TimeWheel::NowMs() - acceptMs > ADMIN_WAIT_MS) { // 排队过久，快照已经过时
+                close(fd);
+                return;
+            }
+            struct timeval tv = { 1, 0 };
+            setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+            setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+            char req[1024];
+            recv(fd, req, sizeof(req), 0); // 读走请求，忽略其内容；不读就关闭会向对端发送 RST
+            std::string resp = "HTTP/1.1 200 OK\r\nConnection: close\r\nContent-type: application/json\r\n"
+                               "Content-length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+            size_t off = 0;
+            while (off < resp.size()) {
+                ssize_t n = send(fd, resp.data() + off, resp.size() - off, 0);
+                if (n <= 0) { break; }
+                off += n;
+            }
+            close(fd);
+        });
+    }
+}
+
+// 生成服务器内部状态的 JSON 快照，只在事件循环中调用
+std::string WebServer::AdminSnapshot_() {
+    int64_t now = TimeWheel::NowMs();
+    std::string conns;
+    int active = 0;
+    int listed = 0;
+    char item[256];
+    for (auto& kv : users_) {
+        HttpConn& conn = kv.second;
+        if (conn.IsClose()) { continue; } // 已关闭的连接对象留在表中等待复用
+        active++;
+        if (listed >= ADMIN_MAX_CONNS) { continue; }
+        int64_t idle = conn.LastActive() > 0 ? now - conn.LastActive() : -1;
+        snprintf(item, sizeof(item),
+                 "%s{\"fd\":%d,\"client\":\"%s:%u\",\"stage\":\"%s\",\"idle_ms\":%lld,\"requests\":%u}",
+                 listed ? "," : "", conn.GetFd(), conn.GetIP(), ntohs(conn.GetAddr().sin_port),
+                 HttpConn::StageName(conn.Stage()), static_cast<long long>(idle), conn.RequestCount());
+        conns += item;
+        listed++;
+    }
+    char head[512];
+    snprintf(head, sizeof(head),
+             "{\"time_ms\":%lld,\"reactors\":[{\"id\":0,\"connections\":%d}],\"connections\":%d,"
+             "\"timers\":%zu,\"threadpool_queue\":%zu,\"db_queue\":%zu,\"register_queue\":%zu,"
+             "\"sessions\":%zu,\"sql_free_connections\":%d,\"sql_connections\":%d,\"log_queued_bytes\":%zu,\"log_dropped\":%llu,"
+             "\"conns_truncated\":%s,\"conns\":[",
+             static_cast<long long>(now), active, HttpConn::userCount.load(), timer_->Size(),
+             threadpool_->QueueSize(), dbExecutor_->QueueSize(), registerBatcher_->QueueSize(),
+             sessions_ ? sessions_->Size() : 0, SqlConnPool::Instance()->GetFreeConnCount(), SqlConnPool::Instance()->GetConnCount(),
+             Log::Instance()->GetQueuedBytes(), static_cast<unsigned long long>(Log::Instance()->GetDroppedTotal()),
+             active > listed ? "true" : "false");
+    return head + conns + "]}\n";
+}
+
 // 处理客户端套接字可读事件
 void WebServer::DealRead_(HttpConn *client) {
     assert(client);
     ExtentTime_(client); // 更新客户端连接的定时器时间
-    threadpool_->AddTask(std::bind(&WebServer::OnRead_, this, client)); // 线程池中添加任务，处理客户端可读事件
+    client->MarkEnqueue();
+    threadpool_->AddTask([this, client] { OnRead_(client); }); // 线程池中添加任务，处理客户端可读事件；只捕获两个指针，std::function 不申请堆内存
 }
 
 // 处理客户端套接字可写事件
 void WebServer::DealWrite_(HttpConn *client) {
     assert(client);
     ExtentTime_(client); // 更新过期时间
-    threadpool_->AddTask(std::bind(&WebServer::OnWrite_, this, client));
+    threadpool_->AddTask([this, client] { OnWrite_(client); });
 }
 
-// 更新客户端的活动时间
+// 更新客户端的活动时间：只记录时间戳，定时器到期时再检查是否真的空闲
 void WebServer::ExtentTime_(HttpConn *client) {
     assert(client);
-    if (timeoutMS_ > 0) { timer_->adjust(client->GetFd(), timeoutMS_); } // 更新客户端的计时器，以确保在一段时间后触发超时处理。
+    if (timeoutMS_ > 0) { client->Touch(TimeWheel::NowMs()); }
+}
+
+// 定时器到期：期间有过活动则按剩余时间重新挂入，否则关闭空闲连接
+void WebServer::OnTimeout_(uint64_t connId) {
+    HttpConn *client = FindConn_(connId);
+    if (!client || client->IsClose()) { return; } // 连接已关闭或 fd 已被新连接复用
+    int64_t idle = timer_->GetNow() - client->LastActive();
+    if (idle < timeoutMS_) {
+        timer_->Add(client->GetTimer(), timeoutMS_ - idle, std::bind(&WebServer::OnTimeout_, this, connId));
+        return;
+    }
+    CloseConn_(client);
+}
+
+// 根据带代数的连接 id 查找连接，代数不匹配说明 fd 已被新连接复用
+HttpConn *WebServer::FindConn_(uint64_t connId) {
+    auto it = users_.find(static_cast<int>(connId & 0xffffffff));
+    if (it == users_.end() || it->second.GetConnId() != connId) { return nullptr; }
+    return &it->second;
+}
+
+// 定时器服务用来把取消请求中的 id 解析为定时器节点
+TimerNode *WebServer::FindTimer_(uint64_t connId) {
+    HttpConn *client = FindConn_(connId);
+    return client ? client->GetTimer() : nullptr;
 }
 
 // 处理客户端的可读事件
@@ -177,6 +469,7 @@ void WebServer::OnRead_(HttpConn *client) {
     assert(client);
     int ret = -1;
     int readErrno = 0;
+    client->MarkDequeue();
     ret = client->read(&readErrno); // 客户端读取数据，存放在读缓冲区中
     if (ret <= 0 && readErrno != EAGAIN) {
         CloseConn_(client); // 关闭客户端连接
@@ -186,14 +479,112 @@ void WebServer::OnRead_(HttpConn *client) {
 }
 
 // 处理客户端读取到的数据
-void WebServer::OnProess(HttpConn *client) {
+void WebServer::OnProcess(HttpConn *client) {
     if (client->process()) {//对客户端读取到的数据进行处理
+        if (client->IsAuthPending()) { // 等数据库完成后再注册可写事件，期间连接不占用工作线程
+            SubmitAuth_(client);
+            return;
+        }
         epoller_->ModFd(client->GetFd(), connEvent_ | EPOLLOUT); // 修改客户端套接字的监听事件，将其设置为可写事件
     } else {
         epoller_->ModFd(client->GetFd(), connEvent_ | EPOLLIN); // 设置为可读事件
     }
 }
 
+// 登录注册的校验，只拷贝用户名与密码，不引用连接对象：
+// 用户缓存能直接判定失败的（登录的用户不存在、注册的用户已存在）在当前工作线程完成；
+// 登录命中缓存时交给哈希执行器校验密码，未命中时先由数据库执行器查询再校验；
+// 注册先由哈希执行器计算哈希，再进入写后队列按批写入。结果都经数据库执行器的完成队列交回事件循环
+void WebServer::SubmitAuth_(HttpConn *client) {
+    const HttpRequest& req = client->GetRequest();
+    std::string name = req.GetPost("username");
+    std::string pwd = req.GetPost("password");
+    bool isLogin = req.IsAuthLogin();
+    uint64_t connId = client->GetConnId();
+    std::string record;
+    bool exists = false;
+    bool hit = !name.empty() && UserCache::Instance()->Get(name, &record, &exists);
+    if (name.empty() || pwd.empty() || (hit && exists != isLogin)) {
+        int64_t now = MetricsNowUs();
+        client->CompleteAuth(false, now, now);
+        epoller_->ModFd(client->GetFd(), connEvent_ | EPOLLOUT);
+        return;
+    }
+    DbExecutor *db = dbExecutor_.get();
+    CpuExecutor *hasher = hashExecutor_.get();
+    std::function<void()> fail = [db, connId] { // 执行器队列已满、排队超时或出错
+        int64_t now = MetricsNowUs();
+        db->Complete({ connId, false, now, now });
+    };
+    if (!isLogin) {
+        RegisterBatcher *batcher = registerBatcher_.get();
+        bool queued = hasher->Submit([=] {
+            std::string hash;
+            if (!PasswordHasher::Hash(pwd, &hash) || !batcher->Submit(connId, name, hash)) { fail(); }
+        }, fail);
+        if (!queued) { fail(); }
+        return;
+    }
+    if (hit) {
+        VerifyPassword_(db, hasher, connId, pwd, record, 0);
+        return;
+    }
+    AuthStore *store = authStore_.get();
+    db->Post(connId, [=] {
+        int64_t start = MetricsNowUs();
+        std::string stored;
+        bool found = false;
+        if (!store->Find(name, &stored, &found)) {
+            fail();
+            return;
+        }
+        if (!found) {
+            UserCache::Instance()->PutMissing(name);
+            fail();
+            return;
+        }
+        UserCache::Instance()->Put(name, stored);
+        VerifyPassword_(db, hasher, connId, pwd, stored, start);
+    });
+}
+
+// 在哈希执行器中校验密码，结果经数据库执行器的完成队列交回；startUs 为校验流程开始的时间，0 表示从哈希开始计
+void WebServer::VerifyPassword_(DbExecutor *db, CpuExecutor *hasher, uint64_t connId,
+                                const std::string& pwd, const std::string& record, int64_t startUs) {
+    std::function<void()> fail = [db, connId] {
+        int64_t now = MetricsNowUs();
+        db->Complete({ connId, false, now, now });
+    };
+    bool queued = hasher->Submit([=] {
+        int64_t start = startUs ? startUs : MetricsNowUs();
+        bool ok = PasswordHasher::Verify(pwd, record);
+        db->Complete({ connId, ok, start, MetricsNowUs() });
+    }, fail);
+    if (!queued) { fail(); }
+}
+
+// 事件循环中处理完成的数据库操作：按连接 id 找回连接，生成响应交给线程池
+void WebServer::DealDbCompletions_() {
+    std::vector<DbExecutor::Completion> done;
+    dbExecutor_->TakeCompletions(done);
+    for (const auto& c : done) {
+        HttpConn *client = FindConn_(c.connId);
+        if (!client || client->IsClose() || !client->IsAuthPending()) { continue; } // 等待期间连接已关闭或被复用
+        ExtentTime_(client);
+        threadpool_->AddTask([this, client, c] {
+            client->CompleteAuth(c.ok, c.startUs, c.doneUs);
+            epoller_->ModFd(client->GetFd(), connEvent_ | EPOLLOUT);
+        });
+    }
+}
+
+// 定时器回调：清理过期的会话并重新挂入，会话本身不占用时间轮节点
+void WebServer::SweepSessions_() {
+    size_t removed = sessions_->Expire();
+    if (removed > 0) { LOG_DEBUG("Expired %zu sessions", removed); }
+    timer_->Add(&sessionTimer_, SESSION_SWEEP_MS, std::bind(&WebServer::SweepSessions_, this));
+}
+
 // 处理客户端套接字的写入事件
 void WebServer::OnWrite_(HttpConn *client) {
     assert(client);
@@ -202,6 +593,8 @@ void WebServer::OnWrite_(HttpConn *client) {
     ret = client->write(&writeErrno); // 向客户端套接字写入数据，并返回写入的字节数
     if (client->ToWriteBytes() == 0) { // 检查客户端还有待写入的字节数
         /* 传输完成 */
+        client->LogAccess(); // 记录访问日志
+        client->FinishTrace(); // 统计本次请求的分阶段耗时
         if (client->IsKeepAlive()) { // 首先检查是否需要保持连接
             OnProcess(client); // 处理客户端请求
             return;
@@ -281,6 +674,34 @@ bool WebServer::InitSocket_() {
     return true;
 }
 
+// 创建管理端口的监听套接字，只绑定回环地址
+bool WebServer::InitAdminSocket_() {
+    if (adminPort_ > 65535 || adminPort_ < 1024 || adminPort_ == port_) {
+        LOG_ERROR("Admin port:%d error!", adminPort_);
+        return false;
+    }
+    struct sockaddr_in addr;
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK); // 管理接口不对外暴露
+    addr.sin_port = htons(adminPort_);
+    adminFd_ = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (adminFd_ < 0) {
+        LOG_ERROR("Create admin socket error!");
+        return false;
+    }
+    int optval = 1;
+    setsockopt(adminFd_, SOL_SOCKET, SO_REUSEADDR, (const void *) &optval, sizeof(int));
+    if (bind(adminFd_, (struct sockaddr *) &addr, sizeof(addr)) < 0 || listen(adminFd_, 16) < 0
+        || epoller_->AddFd(adminFd_, EPOLLIN) == 0) {
+        LOG_ERROR("Listen admin port:%d error!", adminPort_);
+        close(adminFd_);
+        adminFd_ = -1;
+        return false;
+    }
+    LOG_INFO("Admin port:%d", adminPort_);
+    return true;
+}
+
 // 将指定文件描述符设置为非阻塞模式
 int WebServer::SetFdNonblock(int fd) {
     assert(fd > 0);
@@ -11,17 +11,28 @@
 #include <unistd.h>      // close()
 #include <assert.h>
 #include <errno.h>
+#include <signal.h>      // signal()
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
+#include <sys/eventfd.h>  // eventfd
 
 #include "epoller.h"
 #include "../log/log.h"
-#include "../timer/heaptimer.h"
+#include "../timer/timerservice.h"
 #include "../pool/sqlconnpool.h"
 #include "../pool/threadpool.h"
 #include "../pool/sqlconnRAII.h"
+#include "../pool/dbexecutor.h"
+#include "../auth/mysqlauthstore.h"
+#include "../auth/localauthstore.h"
+#include "../auth/registerbatcher.h"
+#include "../auth/passwordhasher.h"
+#include "../auth/sessionstore.h"
+#include "../pool/cpuexecutor.h"
 #include "../http/httpconn.h"
+#include "../metrics/metrics.h"
+#include "../config/config.h"
 
 class WebServer {
 public:
@@ -29,17 +40,33 @@ public:
             int port, int trigMode, int timeoutMS, bool OptLinger,
             int sqlPort, const char *sqlUser, const char *sqlPwd,
             const char *dbName, int connPoolNum, int threadNum,
-            bool openLog, int logLevel, int logQueSize);
+            bool openLog, int logLevel, int logQueSize, int traceSample = 0, int adminPort = 0,
+            const char *authFile = "", int connPoolMin = 0, int sqlWaitMs = 1000, int hashThreads = 2,
+            int sessionTtlSec = 1800, const char *sessionFile = "");
 
     ~WebServer();
 
     void Start();
 
+    bool EnableReload(const std::string& confPath);
+
 private:
     bool InitSocket_();
 
     void InitEventMode_(int trigMode);
 
+    void InitMetrics_();
+
+    bool InitAdminSocket_();
+
+    void DealAdmin_();
+
+    std::string AdminSnapshot_();
+
+    void ReloadConfig_();
+
+    static void OnSighup_(int sig);
+
     void AddClient_(int fd, sockaddr_in addr);
 
     void DealListen_();
@@ -54,30 +81,72 @@ private:
 
     void CloseConn_(HttpConn *client);
 
+    void OnTimeout_(uint64_t connId);
+
+    HttpConn *FindConn_(uint64_t connId);
+
+    TimerNode *FindTimer_(uint64_t connId);
+
     void OnRead_(HttpConn *client);
 
     void OnWrite_(HttpConn *client);
 
     void OnProcess(HttpConn *client);
 
+    void SubmitAuth_(HttpConn *client);
+
+    static void VerifyPassword_(DbExecutor *db, CpuExecutor *hasher, uint64_t connId,
+                                const std::string& pwd, const std::string& record, int64_t startUs);
+
+    void DealDbCompletions_();
+
+    void SweepSessions_();
+
     static const int MAX_FD = 65536;
+    static const int ADMIN_MAX_CONNS = 1000; // 管理接口最多列出的连接数
+    static const int ADMIN_QUEUE = 16; // 等待应答的管理连接上限
+    static const int ADMIN_WAIT_MS = 2000; // 管理连接排队的最长时间
+    static const int HASH_QUEUE = 256; // 等待哈希的请求上限
+    static const int HASH_WAIT_MS = 2000; // 等待哈希的最长时间
+    static const int DB_QUEUE = 256; // 等待数据库线程的操作上限
+    static const int DB_WAIT_MS = 2000; // 等待数据库线程的最长时间
+    static const int SESSION_CAPACITY = 100000; // 会话数上限
+    static const int SESSION_SWEEP_MS = 1000; // 清理过期会话的间隔
 
     static int SetFdNonblock(int fd);
 
     int port_; //端口
     bool openLinger_; // 优雅退出
-    int timeoutMS_;  /* 毫秒MS */
+    std::atomic<int> timeoutMS_;  /* 毫秒MS，可经 SIGHUP 重新加载，工作线程关闭连接时也会读取 */
     bool isClose_; //服务器是否关闭
     int listenFd_; // 监听文件描述符
+    int adminPort_; // 管理端口，0 表示不开启
+    int adminFd_; // 管理端口的监听文件描述符
     char *srcDir_; // 目录
+    bool openLog_; // 是否开启日志
+    int traceSample_; // 请求追踪采样间隔
+
+    std::string confPath_; // 配置文件路径，SIGHUP 时重新读取
+    Config bootConf_; // 启动时的配置，用于发现只能重启生效的修改
+    static int reloadFd_; // SIGHUP 处理函数写入的 eventfd，事件循环在其上执行重新加载
 
     uint32_t listenEvent_; // 监听事件
     uint32_t connEvent_; // 连接事件
 
-    std::unique_ptr <HeapTimer> timer_;//基于小根堆实现的定时器
+    std::unique_ptr <TimerService> timer_;//基于分层时间轮实现的定时器，归属于事件循环线程
+    TimerNode sessionTimer_;//周期性清理过期会话的定时器节点
+    std::unique_ptr <SessionStore> sessions_;//会话存储，工作线程签发与校验，在线程池之后析构
     std::unique_ptr <ThreadPool> threadpool_;//线程池
+    std::unique_ptr <ThreadPool> adminPool_;//管理端口的收发线程，慢速的管理客户端不占用处理请求的线程
     std::unique_ptr <Epoller> epoller_;//时间处理模式
+    std::unique_ptr <AuthStore> authStore_;//用户存储，MySQL 或本地文件
+    std::unique_ptr <DbExecutor> dbExecutor_;//数据库执行器，登录在专用线程中访问用户存储
+    std::unique_ptr <RegisterBatcher> registerBatcher_;//注册的写后队列，结果经数据库执行器的完成队列交回
+    std::unique_ptr <CpuExecutor> hashExecutor_;//密码哈希执行器，与处理请求的线程池分开
     std::unordered_map<int, HttpConn> users_;
+
+    Counter* acceptsMetric_; // 接受的连接数
+    Gauge* timersMetric_; // 时间轮中的定时器数
 };
 
 
@@ -0,0 +1,96 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#include "timerservice.h"
+
+// 构造函数，创建它的线程即为时间轮的所属线程
+TimerService::TimerService(const TimerResolver& resolver)
+    : resolver_(resolver), owner_(std::this_thread::get_id()), armedTick_(0) {
+    assert(resolver_);
+    timerFd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    wakeFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    assert(timerFd_ >= 0 && wakeFd_ >= 0);
+}
+
+// 析构函数
+TimerService::~TimerService() {
+    close(timerFd_);
+    close(wakeFd_);
+}
+
+// 添加定时器，只能在所属线程调用；新节点比当前唤醒时刻更早时才重新设置 timerfd
+void TimerService::Add(TimerNode* node, int timeout, const TimeoutCallBack& cb) {
+    assert(IsInOwnerThread());
+    wheel_.add(node, timeout, cb);
+    if(armedTick_ == 0 || node->expires < armedTick_) {
+        Rearm_();
+    }
+}
+
+// 取消 id 对应的定时器：所属线程直接取消，其他线程排队后通过 eventfd 唤醒所属线程
+void TimerService::Cancel(uint64_t id) {
+    if(IsInOwnerThread()) {
+        TimerNode* node = resolver_(id);
+        if(node) { wheel_.cancel(node); }
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> locker(mtx_);
+        pendingCancel_.push_back(id);
+    }
+    uint64_t one = 1;
+    if(write(wakeFd_, &one, sizeof(one)) != sizeof(one)) {
+        LOG_WARN("TimerService wakeup error!");
+    }
+}
+
+// 所属线程处理 eventfd 上投递的取消请求，id 的代数不匹配（fd 已被新连接复用）时忽略
+void TimerService::HandleWakeup() {
+    assert(IsInOwnerThread());
+    uint64_t cnt = 0;
+    while(read(wakeFd_, &cnt, sizeof(cnt)) > 0) {}
+    std::vector<uint64_t> ids;
+    {
+        std::lock_guard<std::mutex> locker(mtx_);
+        ids.swap(pendingCancel_);
+    }
+    for(uint64_t id : ids) {
+        TimerNode* node = resolver_(id);
+        if(node) { wheel_.cancel(node); }
+    }
+}
+
+// timerfd 可读：推进时间轮并按新的最早时刻重新设置
+void TimerService::HandleTimer() {
+    assert(IsInOwnerThread());
+    uint64_t cnt = 0;
+    while(read(timerFd_, &cnt, sizeof(cnt)) > 0) {}
+    armedTick_ = 0;
+    wheel_.tick();
+    Rearm_();
+}
+
+// 把 timerfd 设置到时间轮下一个可能到期的 tick 边界（绝对时间，纳秒精度）；
+// 取消定时器不会重新设置，最多产生一次多余的唤醒
+void TimerService::Rearm_() {
+    if(wheel_.size() == 0) { return; }
+    uint64_t next = wheel_.NextExpires();
+    if(next == armedTick_) { return; }
+    armedTick_ = next;
+    int64_t ms = static_cast<int64_t>(next) * wheel_.tickMs();
+    struct itimerspec its = {};
+    its.it_value.tv_sec = ms / 1000;
+    its.it_value.tv_nsec = (ms % 1000) * 1000000;
+    if(timerfd_settime(timerFd_, TFD_TIMER_ABSTIME, &its, nullptr) < 0) {
+        LOG_ERROR("TimerService timerfd_settime error!");
+    }
+}
+
+// 清空所有定时器
+void TimerService::Clear() {
+    assert(IsInOwnerThread());
+    wheel_.clear();
+    armedTick_ = 0;
+}
@@ -0,0 +1,66 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#ifndef TIMER_SERVICE_H
+#define TIMER_SERVICE_H
+
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <unistd.h>        // read, write, close
+#include <sys/eventfd.h>   // eventfd
+#include <sys/timerfd.h>   // timerfd
+#include <assert.h>
+#include "timewheel.h"
+#include "../log/log.h"
+
+// 根据带代数的连接 id 找到对应的定时器节点，连接已关闭或 fd 已被复用时返回 nullptr
+typedef std::function<TimerNode*(uint64_t id)> TimerResolver;
+
+// 定时器服务：时间轮只归属于创建它的事件循环线程，其他线程只能通过 eventfd 投递取消请求；
+// 到期通过注册在 Epoller 中的 timerfd 通知，只在最早的唤醒时刻变化时重新设置
+class TimerService {
+public:
+    explicit TimerService(const TimerResolver& resolver);
+
+    ~TimerService();
+
+    void Add(TimerNode* node, int timeout, const TimeoutCallBack& cb);
+
+    void Cancel(uint64_t id);
+
+    void HandleTimer();
+
+    int64_t GetNow() const { return wheel_.GetNow(); }
+
+    size_t Size() const { return wheel_.size(); }
+
+    void Clear();
+
+    int WakeupFd() const { return wakeFd_; }
+
+    int TimerFd() const { return timerFd_; }
+
+    void HandleWakeup();
+
+    bool IsInOwnerThread() const { return std::this_thread::get_id() == owner_; }
+
+private:
+    void Rearm_();
+
+    TimeWheel wheel_; // 只在所属线程中访问
+    TimerResolver resolver_; // 连接 id 到定时器节点的映射
+    std::thread::id owner_; // 所属的事件循环线程
+
+    int timerFd_; // 定时器到期通知
+    uint64_t armedTick_; // timerfd 当前设置的唤醒 tick，0 表示未设置
+
+    int wakeFd_; // 跨线程取消请求的通知 eventfd
+    std::mutex mtx_; // 保护 pendingCancel_
+    std::vector<uint64_t> pendingCancel_; // 其他线程投递、等待所属线程处理的取消请求
+};
+
+#endif //TIMER_SERVICE_H
@@ -0,0 +1,187 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#include "timewheel.h"
+
+// 构造函数，各槽的哨兵节点自成环表示空槽
+TimeWheel::TimeWheel(int tickMs) : tickMs_(tickMs), count_(0) {
+    assert(tickMs > 0);
+    nowMs_ = NowMs();
+    curTick_ = nowMs_ / tickMs_;
+    for(int i = 0; i < TVR_SIZE; i++) {
+        tv1_[i].prev = tv1_[i].next = &tv1_[i];
+    }
+    for(int l = 0; l < LEVELS - 1; l++) {
+        for(int i = 0; i < TVN_SIZE; i++) {
+            tvn_[l][i].prev = tvn_[l][i].next = &tvn_[l][i];
+        }
+    }
+}
+
+// 单调时钟的粗粒度毫秒时间，读取开销只有一次 vDSO 调用，用于记录活动时间与计算到期时间
+int64_t TimeWheel::NowMs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+}
+
+// 返回指定层、指定下标的槽
+TimerNode* TimeWheel::Slot_(int level, int index) {
+    return level == 0 ? &tv1_[index] : &tvn_[level - 1][index];
+}
+
+// 根据到期 tick 与当前 tick 的距离把节点挂到对应层的槽尾部
+void TimeWheel::Insert_(TimerNode* node) {
+    uint64_t expires = node->expires;
+    TimerNode* head = nullptr;
+    if(expires < curTick_) { // 已经过期的节点放到下一个待处理的槽
+        head = &tv1_[curTick_ & TVR_MASK];
+    } else {
+        uint64_t idx = expires - curTick_;
+        if(idx > MAX_TICKS) { // 超出时间轮范围的截断到最大值
+            expires = curTick_ + MAX_TICKS;
+            node->expires = expires;
+            idx = MAX_TICKS;
+        }
+        if(idx < TVR_SIZE) {
+            head = &tv1_[expires & TVR_MASK];
+        } else {
+            int level = 1;
+            while(idx >= (1ULL << (TVR_BITS + level * TVN_BITS))) { level++; }
+            head = Slot_(level, (expires >> (TVR_BITS + (level - 1) * TVN_BITS)) & TVN_MASK);
+        }
+    }
+    node->prev = head->prev;
+    node->next = head;
+    head->prev->next = node;
+    head->prev = node;
+}
+
+// 把高层某个槽的节点重新按剩余时间分配到低层
+void TimeWheel::Cascade_(int level, int index) {
+    TimerNode* head = Slot_(level, index);
+    TimerNode* node = head->next;
+    head->prev = head->next = head;
+    while(node != head) {
+        TimerNode* next = node->next;
+        Insert_(node);
+        node = next;
+    }
+}
+
+// 添加定时器，节点已在时间轮中时先摘除再按新的超时时间挂入
+void TimeWheel::add(TimerNode* node, int timeout, const TimeoutCallBack& cb) {
+    assert(node && timeout >= 0);
+    int64_t now = NowMs();
+    if(count_ == 0 && curTick_ <= static_cast<uint64_t>(now / tickMs_)) {
+        curTick_ = now / tickMs_; // 空闲期间没有推进时间轮，先跳到当前 tick
+    }
+    if(node->IsLinked()) {
+        node->Unlink();
+    } else {
+        count_++;
+    }
+    node->cb = cb;
+    node->expires = (now + timeout + tickMs_ - 1) / tickMs_;
+    Insert_(node);
+}
+
+// 刷新定时器的超时时间，O(1) 摘除再挂入
+void TimeWheel::adjust(TimerNode* node, int timeout) {
+    assert(node);
+    if(!node->IsLinked()) { return; }
+    node->Unlink();
+    node->expires = (NowMs() + timeout + tickMs_ - 1) / tickMs_;
+    Insert_(node);
+}
+
+// 取消定时器，不触发回调
+void TimeWheel::cancel(TimerNode* node) {
+    assert(node);
+    if(node->IsLinked()) {
+        node->Unlink();
+        count_--;
+    }
+}
+
+// 清空时间轮中所有定时器节点
+void TimeWheel::clear() {
+    for(int l = 0; l < LEVELS; l++) {
+        int n = (l == 0) ? TVR_SIZE : TVN_SIZE;
+        for(int i = 0; i < n; i++) {
+            TimerNode* head = Slot_(l, i);
+            while(head->next != head) {
+                head->next->Unlink();
+            }
+        }
+    }
+    count_ = 0;
+}
+
+// 推进时间轮到当前时间，依次触发已经到期的节点；
+// 使用精确时钟，保证在 tick 边界被唤醒时不会因粗粒度时钟滞后而错过
+void TimeWheel::tick() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    nowMs_ = static_cast<int64_t>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+    uint64_t target = nowMs_ / tickMs_;
+    if(count_ == 0) { // 没有定时器时直接跳到当前 tick
+        if(curTick_ <= target) { curTick_ = target + 1; }
+        return;
+    }
+    while(curTick_ <= target) {
+        int index = curTick_ & TVR_MASK;
+        if(index == 0) { // 第一层转完一圈，逐层向下分配
+            for(int level = 1; level < LEVELS; level++) {
+                int i = (curTick_ >> (TVR_BITS + (level - 1) * TVN_BITS)) & TVN_MASK;
+                Cascade_(level, i);
+                if(i != 0) { break; }
+            }
+        }
+        // 先取出当前槽再推进 tick，回调里新加的已过期节点会落到下一个槽而不是等待一整圈
+        TimerNode expired;
+        TimerNode* head = &tv1_[index];
+        if(head->next != head) {
+            expired.next = head->next;
+            expired.prev = head->prev;
+            expired.next->prev = &expired;
+            expired.prev->next = &expired;
+            head->prev = head->next = head;
+        } else {
+            expired.prev = expired.next = &expired;
+        }
+        curTick_++;
+        while(expired.next != &expired) {
+            TimerNode* node = expired.next;
+            node->Unlink();
+            count_--;
+            TimeoutCallBack cb = std::move(node->cb); // 回调可能重新添加该节点
+            if(cb) { cb(); }
+        }
+    }
+}
+
+// 计算事件循环下一次需要推进时间轮的等待毫秒数，没有定时器时返回 -1
+int TimeWheel::GetNextTick() {
+    if(count_ == 0) {
+        return -1;
+    }
+    int64_t res = static_cast<int64_t>(NextExpires()) * tickMs_ - nowMs_;
+    return res < 0 ? 0 : static_cast<int>(res);
+}
+
+// 下一个可能有节点到期的 tick：第一层余下的槽中第一个非空槽，否则为下一次向下分配的时刻
+uint64_t TimeWheel::NextExpires() const {
+    int index = curTick_ & TVR_MASK;
+    if(index == 0) {
+        return curTick_;
+    }
+    for(int i = index; i < TVR_SIZE; i++) {
+        if(tv1_[i].next != &tv1_[i]) {
+            return curTick_ + (i - index);
+        }
+    }
+    return (curTick_ | TVR_MASK) + 1;
+}
@@ -0,0 +1,97 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#ifndef TIME_WHEEL_H
+#define TIME_WHEEL_H
+
+#include <time.h>
+#include <stdint.h>
+#include <functional>
+#include <assert.h>
+#include "../log/log.h"
+
+typedef std::function<void()> TimeoutCallBack;
+
+// 侵入式定时器节点，直接嵌入到持有者（如 HttpConn）中，增删不需要额外分配内存
+struct TimerNode {
+    TimerNode* prev; // 所在槽链表的前驱，未挂入时间轮时为 nullptr
+    TimerNode* next; // 所在槽链表的后继
+    uint64_t expires; // 到期的 tick 序号
+    TimeoutCallBack cb; // 到期时调用的回调函数
+
+    TimerNode() : prev(nullptr), next(nullptr), expires(0) {}
+    ~TimerNode() { Unlink(); }
+    TimerNode(const TimerNode&) = delete;
+    TimerNode& operator=(const TimerNode&) = delete;
+
+    bool IsLinked() const { return prev != nullptr; }
+
+    // 从所在槽中摘除
+    void Unlink() {
+        if(prev) {
+            prev->next = next;
+            next->prev = prev;
+            prev = next = nullptr;
+        }
+    }
+};
+
+// 分层时间轮：增加、刷新、取消都是 O(1)，由事件循环以粗粒度 tick 驱动
+class TimeWheel {
+public:
+    explicit TimeWheel(int tickMs = TICK_MS);
+
+    ~TimeWheel() { clear(); }
+
+    void add(TimerNode* node, int timeout, const TimeoutCallBack& cb);
+
+    void adjust(TimerNode* node, int timeout);
+
+    void cancel(TimerNode* node);
+
+    void clear();
+
+    void tick();
+
+    int GetNextTick();
+
+    uint64_t NextExpires() const;
+
+    size_t size() const { return count_; }
+
+    int tickMs() const { return tickMs_; }
+
+    // 最近一次 tick 读取的时间，定时器回调中使用无需再读时钟
+    int64_t GetNow() const { return nowMs_; }
+
+    static int64_t NowMs();
+
+private:
+    static const int TICK_MS = 10; // 默认 tick 粒度（毫秒）
+    static const int TVR_BITS = 8; // 第一层 256 个槽
+    static const int TVN_BITS = 6; // 其余各层 64 个槽
+    static const int TVR_SIZE = 1 << TVR_BITS;
+    static const int TVN_SIZE = 1 << TVN_BITS;
+    static const int TVR_MASK = TVR_SIZE - 1;
+    static const int TVN_MASK = TVN_SIZE - 1;
+    static const int LEVELS = 4; // 总共覆盖 2^26 个 tick
+    static const uint64_t MAX_TICKS = (1ULL << (TVR_BITS + (LEVELS - 1) * TVN_BITS)) - 1;
+
+    void Insert_(TimerNode* node);
+
+    void Cascade_(int level, int index);
+
+    TimerNode* Slot_(int level, int index);
+
+    const int tickMs_; // 每个 tick 的毫秒数
+    uint64_t curTick_; // 下一个待处理的 tick
+    int64_t nowMs_; // 最近一次推进时间轮时读取的时间
+    size_t count_; // 挂在时间轮中的节点数
+
+    TimerNode tv1_[TVR_SIZE]; // 第一层的槽（哨兵节点）
+    TimerNode tvn_[LEVELS - 1][TVN_SIZE]; // 其余各层的槽（哨兵节点）
+};
+
+#endif //TIME_WHEEL_H
@@ -4,8 +4,27 @@
  * @copyleft Apache 2.0
  */ 
 #include "../code/log/log.h"
+#include "../code/log/accesslog.h"
 #include "../code/pool/threadpool.h"
+#include "../code/pool/dbexecutor.h"
+#include "../code/pool/sqlconnpool.h"
+#include "../code/auth/usercache.h"
+#include "../code/auth/localauthstore.h"
+#include "../code/auth/registerbatcher.h"
+#include "../code/auth/passwordhasher.h"
+#include "../code/auth/sessionstore.h"
+#include "../code/pool/cpuexecutor.h"
+#include "../code/buffer/chainbuffer.h"
+#include "../code/buffer/arena.h"
+#include "../code/http/formdata.h"
+#include "../code/http/httprequest.h"
+#include "../code/timer/timewheel.h"
+#include "../code/metrics/metrics.h"
+#include "../code/metrics/requesttrace.h"
+#include "../code/config/config.h"
 #include <features.h>
+#include <glob.h>
+#include <poll.h>
 
 #if __GLIBC__ == 2 && __GLIBC_MINOR__ < 30
 #include <sys/syscall.h>
@@ -33,6 +52,17 @@ void TestLog() {
             }
         }
     }
+    cnt = 0;
+    Log::Instance()->init(0, "./testlog3", ".log", 5000, true);
+    Log::Instance()->SetOverflowPolicy(Log::BLOCK_TIMEOUT, 1000);
+    uint64_t dropped = Log::Instance()->GetDroppedTotal();
+    char name[16] = "binary";
+    for(int j = 0; j < 10000; j++) {
+        LOG_BASE(j % 4, "%s %-5s %05d %lu %.2f %c %p %% ====", "Test", name, cnt++, (size_t)j, j / 3.0, 'a' + j % 26, (void*)name);
+    }
+    assert(Log::Instance()->GetDroppedTotal() == dropped);
+    Log::Instance()->SetOverflowPolicy(Log::DROP_LOW_LEVEL);
+    Log::Instance()->write(1, "%s 333333333 %d =============", "Test", cnt);
 }
 
 void ThreadLogTask(int i, int cnt) {
@@ -50,7 +80,450 @@ void TestThreadPool() {
     getchar();
 }
 
+void TestChainBuffer() {
+    int fds[2];
+    assert(pipe(fds) == 0);
+    std::shared_ptr<const char> file(new char[8192], std::default_delete<const char[]>());
+    memset(const_cast<char*>(file.get()), 'f', 8192);
+
+    ChainBuffer buff(16);
+    buff.Append("HTTP/1.1 200 OK\r\n");
+    buff.Append("Content-length: 8192\r\n\r\n");
+    buff.AppendRef(file, file.get(), 8192);
+    buff.Append("tail");
+    size_t total = buff.ReadableBytes();
+    assert(total == 17 + 24 + 8192 + 4);
+
+    int err = 0;
+    std::string out;
+    char tmp[4096];
+    while(buff.ReadableBytes()) {
+        assert(buff.WriteFd(fds[1], &err) > 0);
+        ssize_t n;
+        while(out.size() < total - buff.ReadableBytes() && (n = read(fds[0], tmp, sizeof(tmp))) > 0) {
+            out.append(tmp, n);
+        }
+    }
+    assert(out.size() == total);
+    assert(out.compare(0, 17, "HTTP/1.1 200 OK\r\n") == 0);
+    assert(out.compare(total - 4, 4, "tail") == 0);
+    assert(out[17 + 24] == 'f' && out[total - 5] == 'f');
+    close(fds[0]);
+    close(fds[1]);
+}
+
+void TestFormData() {
+    Arena arena(64);
+    FormData form;
+    std::string body = "username=bob&password=pw";
+    form.Parse(body.data(), body.size(), arena);
+    StrView v;
+    assert(form.Size() == 2 && form.Find("username", &v) && v == "bob" && form.Find("password", &v) && v == "pw");
+    assert(v.data == body.data() + 22 && arena.Used() == 0); // 不需要解码时直接引用请求体
+    assert(!form.Find("user", &v));
+
+    form.Clear();
+    body = "name=o%27neil&a+b=x+y%2Bz&bad=%zz%4&&flag&k=1&k=2";
+    form.Parse(body.data(), body.size(), arena);
+    assert(body == "name=o%27neil&a+b=x+y%2Bz&bad=%zz%4&&flag&k=1&k=2"); // 不修改请求体
+    assert(form.Find("name", &v) && v == "o'neil");
+    assert(form.Find("a b", &v) && v == "x y+z");
+    assert(form.Find("bad", &v) && v == "%zz%4"); // 不完整的转义原样保留
+    assert(form.Find("flag", &v) && v.empty());
+    assert(form.Find("k", &v) && v == "2"); // 同名字段以最后一个为准
+    assert(form.Size() == 6 && arena.Used() > 0);
+
+    form.Clear();
+    body.clear();
+    for(int i = 0; i < FormData::MAX_FIELDS + 4; i++) { body += "f=" + std::to_string(i) + "&"; }
+    form.Parse(body.data(), body.size(), arena);
+    assert(form.Size() == FormData::MAX_FIELDS);
+
+    for(int i = 0; i < 20; i++) { arena.Alloc(24); } // 超出第一块后追加新块
+    assert(arena.BlockCount() > 1);
+    char* big = arena.Alloc(1000);
+    big[999] = 'x';
+    arena.Reset();
+    assert(arena.Used() == 0 && arena.BlockCount() == 1);
+}
+
+void TestHttpRequest() {
+    HttpRequest request;
+    Buffer buff;
+    request.Init();
+    buff.Append("GET /login HTTP/1.1\r\nHost: x\r\nconnection: keep-alive\r\nCookie: a=1; sid=tok\r\n\r\n");
+    assert(request.parse(buff));
+    assert(request.method() == "GET" && request.path() == "/login.html" && request.version() == "1.1");
+    assert(request.path().data[request.path().len] == '\0'); // 路径以 '\0' 结尾，可以直接用于日志
+    assert(request.GetHeader("HOST") == "x" && request.GetHeader("Accept").empty()); // 头部名称不区分大小写
+    assert(request.IsKeepAlive() && request.GetCookie("sid") == "tok" && request.GetCookie("s").empty());
+
+    request.Init();
+    assert(request.path().empty() && request.GetHeader("Host").empty());
+    buff.Append("GET / HTTP/1.0\r\n\r\n");
+    assert(request.parse(buff) && request.path() == "/index.html" && !request.IsKeepAlive());
+
+    request.Init();
+    buff.RetrieveAll();
+    buff.Append("GET /a b HTTP/1.1\r\n\r\n");
+    assert(!request.parse(buff)); // 请求行中多余的空格
+}
+
+void TestTimeWheel() {
+    TimeWheel timer;
+    TimerNode nodes[4];
+    std::vector<int> fired;
+    timer.tick();
+    timer.add(&nodes[0], 30, [&] { fired.push_back(0); });
+    timer.add(&nodes[1], 10, [&] { fired.push_back(1); });
+    timer.add(&nodes[2], 20, [&] { fired.push_back(2); });
+    timer.add(&nodes[3], 3000, [&] { fired.push_back(3); });
+    timer.cancel(&nodes[2]);
+    timer.adjust(&nodes[1], 50);
+    assert(timer.size() == 3);
+    int64_t start = TimeWheel::NowMs();
+    while(TimeWheel::NowMs() - start < 200) {
+        int ms = timer.GetNextTick();
+        assert(ms >= 0);
+        usleep(std::min(ms, 5) * 1000);
+        timer.tick();
+    }
+    assert(fired.size() == 2 && fired[0] == 0 && fired[1] == 1);
+    assert(timer.size() == 1 && nodes[3].IsLinked());
+    timer.clear();
+    assert(timer.size() == 0 && !nodes[3].IsLinked() && timer.GetNextTick() == -1);
+}
+
+void TestAccessLog() {
+    glob_t files;
+    if(glob("./testaccess/access*.log", 0, nullptr, &files) == 0) { // 清除上次运行留下的文件
+        for(size_t i = 0; i < files.gl_pathc; i++) { remove(files.gl_pathv[i]); }
+    }
+    globfree(&files);
+    AccessLog* log = AccessLog::Instance();
+    log->init("./testaccess", 4096, 0);
+    AccessRecord rec = {};
+    rec.ip = htonl(INADDR_LOOPBACK);
+    rec.status = 200;
+    strcpy(rec.method, "GET");
+    strcpy(rec.path, "/a\"b");
+    for(int i = 0; i < 1000; i++) {
+        rec.timeUs = i;
+        rec.seq = i + 1;
+        log->Append(rec);
+        if(i % 250 == 0) { usleep(250 * 1000); } // 留出后台线程批量写出与按大小切换的时间
+    }
+    log->Close();
+    assert(log->GetDropped() == 0);
+    assert(glob("./testaccess/access*.log", 0, nullptr, &files) == 0);
+    assert(files.gl_pathc > 1); // 按大小切换过
+    int lines = 0;
+    for(size_t i = 0; i < files.gl_pathc; i++) {
+        FILE* fp = fopen(files.gl_pathv[i], "r");
+        for(int c; (c = fgetc(fp)) != EOF; ) { lines += (c == '\n'); }
+        fclose(fp);
+    }
+    globfree(&files);
+    assert(lines == 1000);
+}
+
+void TestMetrics() {
+    for(uint64_t v : { 0ULL, 3ULL, 4ULL, 7ULL, 8ULL, 1000ULL, 123456ULL, 1ULL << 32 }) {
+        int idx = Histogram::BucketIndex(v);
+        assert(idx < Histogram::BUCKETS && Histogram::BucketLower(idx) <= v);
+        assert(idx == Histogram::BUCKETS - 1 || Histogram::BucketLower(idx + 1) > v);
+    }
+    MetricsRegistry* reg = MetricsRegistry::Instance();
+    Counter* c = reg->GetCounter("test_total", "Test counter.", "k=\"a\"");
+    assert(reg->GetCounter("test_total", "Test counter.", "k=\"a\"") == c);
+    Histogram* h = reg->GetHistogram("test_seconds", "Test histogram.");
+    std::vector<std::thread> threads;
+    for(int t = 0; t < 4; t++) {
+        threads.emplace_back([=] {
+            for(int i = 1; i <= 1000; i++) { c->Inc(); h->Record(i); }
+        });
+    }
+    for(auto& t : threads) { t.join(); }
+    assert(c->Value() == 4000 && h->Count() == 4000 && h->Sum() == 4 * 500500);
+    uint64_t p50 = h->Percentile(0.5);
+    assert(p50 >= 384 && p50 <= 500);
+    reg->AddCallback("test_gauge", "Test gauge.", "", false, [] { return 7.0; });
+    std::string text = reg->Render();
+    assert(text.find("test_total{k=\"a\"} 4000\n") != std::string::npos);
+    assert(text.find("test_seconds_bucket{le=\"+Inf\"} 4000\n") != std::string::npos);
+    assert(text.find("test_seconds_count 4000\n") != std::string::npos);
+    assert(text.find("test_gauge 7\n") != std::string::npos);
+    reg->Remove("test_gauge");
+    assert(reg->Render().find("test_gauge") == std::string::npos);
+
+    Histogram* sizes = reg->GetHistogram("test_batch_size", "Test le boundaries.", "", 1);
+    sizes->Record(1);
+    sizes->Record(4);
+    sizes->Record(5);
+    text = reg->Render();
+    assert(text.find("test_batch_size_bucket{le=\"1\"} 1\n") != std::string::npos); // 等于 le 的值计入该桶
+    assert(text.find("test_batch_size_bucket{le=\"2\"} 1\n") != std::string::npos);
+    assert(text.find("test_batch_size_bucket{le=\"4\"} 2\n") != std::string::npos);
+    assert(text.find("test_batch_size_bucket{le=\"8\"} 3\n") != std::string::npos);
+}
+
+void TestRequestTrace() {
+    RequestTracer* tracer = RequestTracer::Instance();
+    Histogram* verify = MetricsRegistry::Instance()->GetHistogram(
+        "webserver_request_phase_seconds", "Request latency by phase.", "phase=\"verify\"");
+    Histogram* parse = MetricsRegistry::Instance()->GetHistogram(
+        "webserver_request_phase_seconds", "Request latency by phase.", "phase=\"parse\"");
+    uint64_t parseSum = parse->Sum();
+    tracer->Init("./testtrace.json", 2);
+    RequestTrace t;
+    t.Reset();
+    t.enqueue = 1000; t.dequeue = 1010; t.parseStart = 1030; t.parseDone = 1050; t.dbStart = 1060;
+    t.dbDone = 1110; t.handlerDone = 1120; t.firstByte = 1200; t.lastByte = 1300;
+    for(int i = 0; i < 4; i++) { tracer->Finish(t, 7, "/a\"b", 200); }
+    t.Reset();
+    tracer->Finish(t, 7, "/", 200); // 未完整经历的请求不计入
+    tracer->Close();
+    assert(verify->Count() == 4 && parse->Sum() - parseSum == 4 * 20);
+    FILE* fp = fopen("./testtrace.json", "r");
+    assert(fp);
+    char line[512];
+    int events = 0, totals = 0;
+    while(fgets(line, sizeof(line), fp)) {
+        if(strstr(line, "\"ph\":\"X\"")) { events++; }
+        if(strstr(line, "\"path\":\"/a\\\"b\"")) { totals++; }
+    }
+    fclose(fp);
+    assert(events == 2 * 9 && totals == 2); // 每 2 个采样一个，每个请求 9 个阶段
+}
+
+void TestConfig() {
+    FILE* fp = fopen("./testconfig.conf", "w");
+    fputs("# comment\n port = 1316 \nlog_level=2 # trailing\n\nopen_log = off\nname = a b\nbad = x1\n", fp);
+    fclose(fp);
+    Config conf;
+    std::string err;
+    assert(conf.Load("./testconfig.conf", &err));
+    int port = 0, level = 0, missing = 7, bad = 0;
+    bool openLog = true;
+    std::string name;
+    assert(conf.ReadInt("port", &port) && port == 1316);
+    assert(conf.ReadInt("log_level", &level) && level == 2);
+    assert(conf.ReadInt("missing", &missing) && missing == 7);
+    assert(conf.ReadBool("open_log", &openLog) && !openLog);
+    assert(conf.ReadString("name", &name) && name == "a b");
+    assert(!conf.ReadInt("bad", &bad));
+
+    fp = fopen("./testconfig.conf", "w");
+    fputs("port = 1\nno equals sign\n", fp);
+    fclose(fp);
+    assert(!conf.Load("./testconfig.conf", &err) && err.find(":2:") != std::string::npos);
+    assert(conf.ReadInt("port", &port) && port == 1316); // 加载失败时保留原有内容
+    assert(!conf.Load("./nonexistent.conf", &err));
+    remove("./testconfig.conf");
+}
+
+void TestDbExecutor() {
+    DbExecutor db(4, 256, 1000);
+    for(uint64_t id = 0; id < 100; id++) {
+        db.Submit(id, [id] { usleep(100); return id % 2 == 0; });
+    }
+    std::vector<bool> seen(100, false);
+    std::vector<DbExecutor::Completion> done;
+    int total = 0;
+    while(total < 100) {
+        struct pollfd pfd = { db.EventFd(), POLLIN, 0 };
+        assert(poll(&pfd, 1, 1000) == 1); // 完成时一定会写 eventfd
+        db.TakeCompletions(done);
+        for(const auto& c : done) {
+            assert(c.connId < 100 && !seen[c.connId] && c.ok == (c.connId % 2 == 0) && c.doneUs >= c.startUs);
+            seen[c.connId] = true;
+            total++;
+        }
+    }
+    assert(db.QueueSize() == 0);
+
+    DbExecutor slow(1, 2, 50); // 队列最多 2 个，排队超过 50ms 不再执行
+    std::atomic<int> ran(0);
+    slow.Submit(0, [&] { ran++; usleep(200 * 1000); return true; });
+    usleep(20 * 1000); // 等第一个操作开始执行
+    for(uint64_t id = 1; id <= 3; id++) {
+        slow.Submit(id, [&] { ran++; return true; }); // 第 3 个被拒绝，前 2 个排队超时
+    }
+    std::vector<bool> ok(4, false);
+    total = 0;
+    while(total < 4) {
+        struct pollfd pfd = { slow.EventFd(), POLLIN, 0 };
+        assert(poll(&pfd, 1, 1000) == 1);
+        slow.TakeCompletions(done);
+        for(const auto& c : done) { ok[c.connId] = c.ok; total++; }
+    }
+    assert(ok[0] && !ok[1] && !ok[2] && !ok[3] && ran == 1);
+}
+
+void TestUserCache() {
+    UserCache cache(32, 1000, 20); // 每个分片 2 条
+    std::string pwd;
+    bool exists = true;
+    assert(!cache.Get("alice", &pwd, &exists));
+    cache.Put("alice", "pw");
+    assert(cache.Get("alice", &pwd, &exists) && exists && pwd == "pw");
+    cache.PutMissing("alice"); // 不覆盖存在的用户
+    assert(cache.Get("alice", &pwd, &exists) && exists);
+    cache.PutMissing("bob");
+    assert(cache.Get("bob", &pwd, &exists) && !exists);
+    usleep(30 * 1000);
+    assert(!cache.Get("bob", &pwd, &exists)); // 不存在的记录先过期
+    cache.Put("bob", "x"); // 注册后写入
+    assert(cache.Get("bob", &pwd, &exists) && exists && pwd == "x");
+    for(int i = 0; i < 1000; i++) { cache.Put("user" + std::to_string(i), "p"); }
+    assert(cache.Size() <= 32);
+    cache.Erase("user999");
+    assert(!cache.Get("user999", &pwd, &exists));
+}
+
+void TestLocalAuthStore() {
+    remove("./testusers.db");
+    std::string err, pwd;
+    bool found = true;
+    {
+        LocalAuthStore store;
+        assert(store.Open("./testusers.db", &err));
+        assert(store.Find("alice", &pwd, &found) && !found);
+        assert(store.Insert("alice", "p\tw\n"));
+        assert(!store.Insert("alice", "other")); // 用户已存在
+        assert(store.Insert("bob", "x"));
+    }
+    int fd = open("./testusers.db", O_WRONLY | O_APPEND);
+    assert(write(fd, "\x05\x00", 2) == 2); // 模拟写了一半的记录
+    close(fd);
+    LocalAuthStore store;
+    assert(store.Open("./testusers.db", &err) && store.Size() == 2);
+    assert(store.Find("alice", &pwd, &found) && found && pwd == "p\tw\n");
+    assert(store.Insert("carol", "c"));
+    LocalAuthStore reopened;
+    assert(reopened.Open("./testusers.db", &err) && reopened.Size() == 3); // 残缺记录已截掉，新记录可以重放
+    remove("./testusers.db");
+}
+
+void TestSqlConnPool() {
+    SqlConnPool* pool = SqlConnPool::Instance();
+    pool->Init("localhost", 1, "nobody", "x", "nodb", 1, 2, 50); // 端口 1 上没有数据库，连接总是失败
+    assert(pool->GetConnCount() == 0);
+    int64_t start = MetricsNowUs();
+    assert(pool->GetConn() == nullptr); // 最多等待 50ms 后放弃，而不是一直阻塞
+    assert(MetricsNowUs() - start >= 50 * 1000);
+    pool->ClosePool();
+}
+
+void TestRegisterBatcher() {
+    remove("./testbatch.db");
+    std::string err;
+    LocalAuthStore store;
+    assert(store.Open("./testbatch.db", &err));
+    assert(store.Insert("old", "o"));
+    std::mutex mtx;
+    std::vector<int> result(10, -1);
+    {
+        RegisterBatcher batcher(&store, [&](uint64_t id, bool ok, int64_t startUs, int64_t doneUs) {
+            std::lock_guard<std::mutex> locker(mtx);
+            assert(result[id] == -1 && doneUs >= startUs);
+            result[id] = ok;
+        }, 4, 20);
+        for(uint64_t id = 0; id < 8; id++) { assert(batcher.Submit(id, "user" + std::to_string(id), "p")); }
+        assert(batcher.Submit(8, "user0", "p")); // 与队列中的注册重名
+        assert(batcher.Submit(9, "old", "p")); // 已存在
+    } // 析构时写完排队的注册
+    for(int id = 0; id < 8; id++) { assert(result[id] == 1); }
+    assert(result[8] == 0 && result[9] == 0 && store.Size() == 9);
+    remove("./testbatch.db");
+}
+
+void TestPasswordHasher() {
+    std::string record, other;
+    assert(PasswordHasher::Hash("secret", &record) && record.compare(0, 10, "scrypt$14$") == 0);
+    assert(PasswordHasher::Hash("secret", &other) && other != record); // 每次使用新的盐
+    assert(PasswordHasher::Verify("secret", record) && !PasswordHasher::Verify("secreT", record));
+    assert(PasswordHasher::Verify("plain", "plain") && !PasswordHasher::Verify("plain", "plain2")); // 旧的明文记录
+    std::string costly = record;
+    costly.replace(7, 2, "30"); // 超出允许代价的记录直接拒绝
+    assert(!PasswordHasher::Verify("secret", costly));
+    assert(!PasswordHasher::Verify("secret", "scrypt$14$8$1$zz$00"));
+}
+
+void TestSessionStore() {
+    remove("./testsessions.db");
+    std::string err, user, token, forged;
+    {
+        SessionStore store(60, 1000);
+        assert(store.Open("./testsessions.db", &err));
+        token = store.Create("alice");
+        assert(token.size() == 65 && store.Check(token, &user) && user == "alice");
+        forged = token;
+        forged[0] = forged[0] == 'a' ? 'b' : 'a'; // 改动 id 后签名不再匹配
+        assert(!store.Check(forged, &user) && !store.Check("", &user));
+        assert(store.Expire() == 0 && store.Size() == 1);
+    }
+    SessionStore reopened(60, 1000);
+    assert(reopened.Open("./testsessions.db", &err)); // 密钥与会话都从文件恢复
+    assert(reopened.Check(token, &user) && user == "alice");
+    SessionStore other(60, 1000); // 不同的密钥签发的会话互不承认
+    assert(!other.Check(token, &user));
+    SessionStore small(1, 16); // 每个分片只保留一个会话
+    std::string first = small.Create("a");
+    for(int i = 0; i < 200; i++) { small.Create("b"); }
+    assert(small.Size() <= 16 && !small.Check(first, &user)); // 最早的会话已被淘汰
+    sleep(2);
+    assert(small.Expire() > 0 && small.Size() == 0);
+    remove("./testsessions.db");
+
+    struct stat st;
+    {
+        SessionStore churn(1, 1000);
+        assert(churn.Open("./testsessions.db", &err));
+        std::string longName(1000, 'u');
+        for(int i = 0; i < 100; i++) { churn.Create(longName); }
+        assert(stat("./testsessions.db", &st) == 0 && st.st_size > 100 * 1000);
+        sleep(2);
+        assert(churn.Expire() == 100); // 全部过期后文件只剩下文件头
+        assert(stat("./testsessions.db", &st) == 0 && st.st_size < 1000);
+        off_t compacted = st.st_size;
+        churn.Create("carol");
+        assert(stat("./testsessions.db", &st) == 0 && st.st_size > compacted); // 重写后继续追加到新文件
+    }
+    remove("./testsessions.db");
+}
+
+void TestCpuExecutor() {
+    std::atomic<int> ran(0), expired(0);
+    std::atomic<bool> started(false);
+    {
+        CpuExecutor executor("test", 1, 2, 20);
+        assert(executor.Submit([&] { started = true; usleep(50 * 1000); ran++; }, [&] { expired++; }));
+        while(!started) { usleep(1000); }
+        assert(executor.Submit([&] { ran++; }, [&] { expired++; }));
+        assert(executor.Submit([&] { ran++; }, [&] { expired++; }));
+        assert(!executor.Submit([&] { ran++; }, [&] { expired++; })); // 队列已满
+    }
+    assert(ran == 1 && expired == 2); // 排队超过 20ms 的任务不再执行
+}
+
 int main() {
+    TestConfig();
+    TestSqlConnPool();
+    TestUserCache();
+    TestLocalAuthStore();
+    TestRegisterBatcher();
+    TestPasswordHasher();
+    TestSessionStore();
+    TestCpuExecutor();
+    TestDbExecutor();
+    TestMetrics();
+    TestRequestTrace();
+    TestChainBuffer();
+    TestFormData();
+    TestHttpRequest();
+    TestTimeWheel();
+    TestAccessLog();
     TestLog();
     TestThreadPool();
 }
\ No newline at end of file